@@ -0,0 +1,199 @@
+#include <atomic>
+#include <thread>
+
+#include "bench_runner.h"
+#include "rtdetr_utils.h"
+#include "rtdetr_motion.h"
+#include "vast_memory.h"
+#include "otl/thread/thread_pool.h"
+
+namespace bench {
+
+    struct ImageSize {
+        int width;
+        int height;
+    };
+
+    static const ImageSize kImageSizes[] = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+    static const int kModelSizes[] = {640, 1024};
+    static const int kClassNums[] = {1, 80};
+
+    static void bench_letter_box(BenchRunner& runner) {
+        for (const ImageSize& size : kImageSizes) {
+            cv::Mat image = synthetic_image(size.width, size.height, 3, 1);
+            for (int model_size : kModelSizes) {
+                for (int scale_fill = 0; scale_fill <= 1; ++scale_fill) {
+                    Params params = {{"width", to_string(size.width)}, {"height", to_string(size.height)},
+                                    {"model_size", to_string(model_size)}, {"scale_fill", to_string(scale_fill)}};
+                    runner.run("letter_box", params, 1, [&]() {
+                        float scale_x, scale_y;
+                        int padding_top, padding_bottom, padding_left, padding_right;
+                        cv::Mat padded = seeta::letter_box(image, model_size, model_size, scale_x, scale_y,
+                                            padding_top, padding_bottom, padding_left, padding_right, scale_fill != 0);
+                        do_not_optimize(padded.data);
+                    });
+                }
+            }
+        }
+    }
+
+    static void bench_preprocess(BenchRunner& runner) {
+        for (const ImageSize& size : kImageSizes) {
+            cv::Mat image = synthetic_image(size.width, size.height, 3, 2);
+            for (int model_size : kModelSizes) {
+                std::vector<float> chw_data(3 * model_size * model_size);
+                Params params = {{"width", to_string(size.width)}, {"height", to_string(size.height)},
+                                {"model_size", to_string(model_size)}};
+                runner.run("preprocess", params, 1, [&]() {
+                    float scale_x, scale_y;
+                    int padding_top, padding_bottom, padding_left, padding_right;
+                    seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                                    padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                    do_not_optimize(chw_data[0]);
+                });
+            }
+        }
+    }
+
+    static void bench_postprocess(BenchRunner& runner) {
+        const int num_queries = 300;
+        for (int cls_num : kClassNums) {
+            std::vector<float> raw_output = synthetic_output(num_queries, cls_num, 0.1f, 3);
+            std::vector<detect_result> results;
+            results.reserve(num_queries);
+            Params params = {{"num_queries", to_string(num_queries)}, {"cls_num", to_string(cls_num)}};
+            runner.run("postprocess", params, 1, [&]() {
+                results.clear();
+                seeta::postprocess(raw_output.data(), num_queries, cls_num, 1920, 1080, 0.5f, results);
+                do_not_optimize(results.size());
+            });
+            // the specialized class counts against the loop every other class count runs
+            runner.run("postprocess_generic", params, 1, [&]() {
+                results.clear();
+                seeta::postprocess_generic(raw_output.data(), num_queries, cls_num, 1920, 1080, 0.5f, results);
+                do_not_optimize(results.size());
+            });
+            std::vector<detect_result> generic;
+            seeta::postprocess_generic(raw_output.data(), num_queries, cls_num, 1920, 1080, 0.5f, generic);
+            results.clear();
+            seeta::postprocess(raw_output.data(), num_queries, cls_num, 1920, 1080, 0.5f, results);
+            bool same = results.size() == generic.size();
+            for (size_t i = 0; same && i < results.size(); ++i) {
+                const detect_result& a = results[i];
+                const detect_result& b = generic[i];
+                same = a.score == b.score && a.cls == b.cls && a.track_id == b.track_id &&
+                       a.box.x == b.box.x && a.box.y == b.box.y && a.box.width == b.box.width &&
+                       a.box.height == b.box.height;
+            }
+            if (!same) runner.fail("postprocess cls_num=" + to_string(cls_num) + " differs from postprocess_generic");
+        }
+    }
+
+    static void bench_cxcywh_to_xyxy(BenchRunner& runner) {
+        const int ops = 1000;
+        std::vector<float> boxes = synthetic_output(ops, 0, 0.0f, 4);
+        runner.run("cxcywh_to_xyxy", Params(), ops, [&]() {
+            for (int i = 0; i < ops; ++i) {
+                std::vector<float> xyxy = seeta::cxcywh_to_xyxy(
+                    std::vector<float>{boxes[i * 4], boxes[i * 4 + 1], boxes[i * 4 + 2], boxes[i * 4 + 3]});
+                // the result buffer escapes, so neither the allocations nor the conversion can be elided
+                do_not_optimize(xyxy.data());
+            }
+        });
+    }
+
+    static void bench_vast_memory(BenchRunner& runner) {
+        const int ops = 1000;
+        const int groups = 16;
+        const int group_size = 3 * 640 * 640;
+        otl::vast_memory<float> vast_memory(group_size, groups);
+
+        for (int threads : {1, 4}) {
+            Params params = {{"threads", to_string(threads)}, {"groups", to_string(groups)}};
+            runner.run("vast_memory_get_put", params, ops * threads, [&]() {
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; ++t) {
+                    workers.emplace_back([&]() {
+                        for (int i = 0; i < ops; ++i) {
+                            int idx;
+                            float* memory = vast_memory.get_memory(idx);
+                            if (memory != nullptr) {
+                                do_not_optimize(memory);
+                                vast_memory.put_memory_back(idx);
+                            }
+                        }
+                    });
+                }
+                for (auto& worker : workers) worker.join();
+            });
+        }
+    }
+
+    static void bench_thread_pool(BenchRunner& runner) {
+        const int ops = 1000;
+        for (int workers : {1, 4}) {
+            otl::ThreadPool thread_pool(workers);
+            std::atomic<int> counter(0);
+            Params params = {{"workers", to_string(workers)}};
+            runner.run("thread_pool_run", params, ops, [&]() {
+                for (int i = 0; i < ops; ++i) {
+                    thread_pool.run([&counter](int idx) {
+                        counter++;
+                    });
+                }
+                thread_pool.join();
+            });
+            do_not_optimize(counter.load());
+        }
+    }
+
+    static void bench_write_results(BenchRunner& runner) {
+        std::string saved_txt = runner.options().tmp_path + "/rtdetr_bench_results.txt";
+        for (int boxes_num : {20, 300}) {
+            std::vector<detect_result> results;
+            Lcg lcg(5);
+            for (int i = 0; i < boxes_num; ++i) {
+                detect_result result;
+                result.box.x = 1920 * lcg.uniform();
+                result.box.y = 1080 * lcg.uniform();
+                result.box.width = 100 * lcg.uniform();
+                result.box.height = 100 * lcg.uniform();
+                result.score = lcg.uniform();
+                result.cls = lcg.next() % 80;
+                result.track_id = -1;
+                results.push_back(result);
+            }
+            Params params = {{"boxes", to_string(boxes_num)}};
+            runner.run("write_results", params, 1, [&]() {
+                seeta::write_results(saved_txt, results);
+            });
+        }
+        remove(saved_txt.c_str());
+    }
+
+    static void bench_motion_gate(BenchRunner& runner) {
+        for (const ImageSize& size : kImageSizes) {
+            cv::Mat reference = synthetic_image(size.width, size.height, 3, 7);
+            cv::Mat image = synthetic_image(size.width, size.height, 3, 8);
+            seeta::MotionGate motion_gate;
+            motion_gate.check(reference);
+            motion_gate.accept();
+            Params params = {{"width", to_string(size.width)}, {"height", to_string(size.height)}};
+            runner.run("motion_gate_check", params, 1, [&]() {
+                seeta::motion_result motion = motion_gate.check(image);
+                do_not_optimize(motion.changed_ratio);
+            });
+        }
+    }
+
+    void bench_cpu_hot_paths(BenchRunner& runner) {
+        bench_letter_box(runner);
+        bench_preprocess(runner);
+        bench_postprocess(runner);
+        bench_cxcywh_to_xyxy(runner);
+        bench_vast_memory(runner);
+        bench_thread_pool(runner);
+        bench_write_results(runner);
+        bench_motion_gate(runner);
+    }
+}
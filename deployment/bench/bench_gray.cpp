@@ -0,0 +1,63 @@
+#include "bench_runner.h"
+#include "rtdetr_utils.h"
+
+namespace bench {
+
+    // gray datasets (convert_dataset.py writes gray BMPs): one channel decode and preprocess
+    // against the bgr expansion the color path needs. decoded_bytes is the memory per frame.
+    static const int kGraySizes[][2] = {{640, 512}, {1024, 1024}, {1920, 1080}};
+    static const int kGrayModelSize = 640;
+
+    static void bench_gray_decode(BenchRunner& runner) {
+        for (auto& size : kGraySizes) {
+            cv::Mat gray = synthetic_image(size[0], size[1], 1, 11);
+            std::vector<unsigned char> encoded;
+            cv::imencode(".bmp", gray, encoded);
+            for (int flags : {cv::IMREAD_GRAYSCALE, cv::IMREAD_COLOR}) {
+                int channels = flags == cv::IMREAD_GRAYSCALE ? 1 : 3;
+                Params params = {{"width", to_string(size[0])}, {"height", to_string(size[1])},
+                                {"channels", to_string(channels)},
+                                {"decoded_bytes", to_string(size[0] * size[1] * channels)}};
+                runner.run("gray_decode", params, 1, [&]() {
+                    cv::Mat image = cv::imdecode(encoded, flags);
+                    do_not_optimize(image.data);
+                });
+            }
+        }
+    }
+
+    static void bench_gray_preprocess(BenchRunner& runner) {
+        std::vector<float> chw_data(3 * kGrayModelSize * kGrayModelSize);
+        for (auto& size : kGraySizes) {
+            cv::Mat gray = synthetic_image(size[0], size[1], 1, 12);
+            Params params = {{"width", to_string(size[0])}, {"height", to_string(size[1])},
+                            {"model_size", to_string(kGrayModelSize)}};
+
+            params.push_back({"path", "gray"});
+            runner.run("gray_preprocess", params, 1, [&]() {
+                float scale_x, scale_y;
+                int padding_top, padding_bottom, padding_left, padding_right;
+                seeta::preprocess(gray, kGrayModelSize, kGrayModelSize, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                do_not_optimize(chw_data[0]);
+            });
+
+            // what the 3 channel path costs: expand to bgr, then the color preprocess
+            params.back().second = "expand_bgr";
+            runner.run("gray_preprocess", params, 1, [&]() {
+                cv::Mat bgr;
+                cv::cvtColor(gray, bgr, cv::COLOR_GRAY2BGR);
+                float scale_x, scale_y;
+                int padding_top, padding_bottom, padding_left, padding_right;
+                seeta::preprocess(bgr, kGrayModelSize, kGrayModelSize, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                do_not_optimize(chw_data[0]);
+            });
+        }
+    }
+
+    void bench_gray_input(BenchRunner& runner) {
+        bench_gray_decode(runner);
+        bench_gray_preprocess(runner);
+    }
+}
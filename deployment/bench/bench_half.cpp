@@ -0,0 +1,65 @@
+#include "bench_runner.h"
+#include "rtdetr_utils.h"
+#include "rtdetr_half.h"
+
+namespace bench {
+
+    // fp16 io engines: half preprocess against the float one, and widening of the raw output
+    void bench_half_io(BenchRunner& runner) {
+        const int model_size = 1024;
+        const int plane_size = model_size * model_size;
+        std::vector<float> chw_data(3 * plane_size);
+        std::vector<uint16_t> chw_half(3 * plane_size);
+        std::vector<uint16_t> reference(3 * plane_size);
+
+        for (int channels : {3, 1}) {
+            cv::Mat image = synthetic_image(1920, 1080, channels, 31);
+            float scale_x, scale_y;
+            int padding_top, padding_bottom, padding_left, padding_right;
+
+            seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                            padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+            for (size_t i = 0; i < chw_data.size(); ++i) reference[i] = seeta::float_to_half_scalar(chw_data[i]);
+            seeta::preprocess_half(image, model_size, model_size, scale_x, scale_y,
+                            padding_top, padding_bottom, padding_left, padding_right, true, chw_half.data());
+            int mismatches = 0;
+            for (size_t i = 0; i < reference.size(); ++i) {
+                // one ulp apart at most, float preprocess rounds x / 255 once more
+                int diff = int(reference[i]) - int(chw_half[i]);
+                if (diff > 1 || diff < -1) mismatches++;
+            }
+            if (mismatches > 0) {
+                runner.fail("preprocess_half mismatch, channels " + to_string(channels) + ", values " +
+                            to_string(mismatches));
+            }
+
+            Params params = {{"model_size", to_string(model_size)}, {"channels", to_string(channels)}};
+            runner.run("preprocess_float", params, 1, [&]() {
+                seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                do_not_optimize(chw_data[0]);
+            });
+            runner.run("preprocess_half", params, 1, [&]() {
+                seeta::preprocess_half(image, model_size, model_size, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, chw_half.data());
+                do_not_optimize(chw_half[0]);
+            });
+        }
+
+        // raw output of 300 queries x (4 + 80 classes)
+        const int output_size = 300 * 84;
+        std::vector<float> output = synthetic_output(300, 80, 0.1f, 32);
+        std::vector<uint16_t> output_half(output_size);
+        seeta::float_to_half(output.data(), output_half.data(), output_size);
+        std::vector<float> widened(output_size);
+        Params params = {{"values", to_string(output_size)}};
+        runner.run("half_to_float", params, 1, [&]() {
+            seeta::half_to_float(output_half.data(), widened.data(), output_size);
+            do_not_optimize(widened[0]);
+        });
+        runner.run("half_to_float_scalar", params, 1, [&]() {
+            for (int i = 0; i < output_size; ++i) widened[i] = seeta::half_to_float_scalar(output_half[i]);
+            do_not_optimize(widened[0]);
+        });
+    }
+}
@@ -0,0 +1,75 @@
+#include <cmath>
+
+#include "bench_runner.h"
+#include "rtdetr_utils.h"
+#include "rtdetr_kernels.h"
+
+namespace bench {
+
+    // device letterbox (set_device_preprocess): its cpu reference against seeta::preprocess, and the
+    // host work left per frame. letterbox_gpu runs letterbox_pixel too, so the reference stands for it
+    void bench_device_letterbox(BenchRunner& runner) {
+        const int model_size = 640;
+        const int plane_size = model_size * model_size;
+        std::vector<float> chw_data(3 * plane_size);
+        std::vector<float> reference(3 * plane_size);
+        std::vector<char> tables_buffer;
+
+        struct frame_size { int width; int height; };
+        for (frame_size size : {frame_size{1920, 1080}, frame_size{1280, 720}, frame_size{320, 240}}) {
+            for (int channels : {3, 1}) {
+                cv::Mat image = synthetic_image(size.width, size.height, channels, 41);
+                float scale_x, scale_y;
+                int padding_top, padding_bottom, padding_left, padding_right;
+
+                seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                seeta::letterbox_geometry geometry = seeta::make_letterbox_geometry(image, model_size, model_size,
+                                scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, true);
+                tables_buffer.resize(seeta::letterbox_tables_size(geometry));
+                seeta::letterbox_tables tables = seeta::build_letterbox_tables(geometry, tables_buffer.data());
+                seeta::letterbox_cpu(image.data, image.step, geometry, tables, reference.data());
+
+                // letterbox_pixel rounds like the uint8 INTER_LINEAR of cv::resize, any difference is a bug
+                int mismatches = 0;
+                float max_diff = 0.0f;
+                for (size_t i = 0; i < reference.size(); ++i) {
+                    float diff = std::fabs(reference[i] - chw_data[i]);
+                    if (diff > 0.0f) mismatches++;
+                    max_diff = std::max(max_diff, diff);
+                }
+                if (mismatches > 0) {
+                    runner.fail("letterbox_cpu mismatch, " + to_string(size.width) + "x" + to_string(size.height) +
+                                " channels " + to_string(channels) + ", max diff " + to_string(max_diff * 255) +
+                                " levels");
+                }
+                std::cerr << "letterbox_cpu " << size.width << "x" << size.height << " channels " << channels
+                        << ": " << mismatches << "/" << reference.size() << " values differ from preprocess"
+                        << std::endl;
+
+                Params params = {{"frame", to_string(size.width) + "x" + to_string(size.height)},
+                                {"model_size", to_string(model_size)}, {"channels", to_string(channels)}};
+                runner.run("letterbox_host_preprocess", params, 1, [&]() {
+                    seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                                    padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                    do_not_optimize(chw_data[0]);
+                });
+                // what stays on the host with device preprocessing, tables only when the size changes
+                runner.run("letterbox_device_host_side", params, 1, [&]() {
+                    seeta::letterbox_geometry frame_geometry = seeta::make_letterbox_geometry(image, model_size,
+                                    model_size, scale_x, scale_y, padding_top, padding_bottom, padding_left,
+                                    padding_right, true);
+                    do_not_optimize(frame_geometry);
+                });
+                runner.run("letterbox_tables", params, 1, [&]() {
+                    seeta::build_letterbox_tables(geometry, tables_buffer.data());
+                    do_not_optimize(tables_buffer[0]);
+                });
+                runner.run("letterbox_cpu_reference", params, 1, [&]() {
+                    seeta::letterbox_cpu(image.data, image.step, geometry, tables, reference.data());
+                    do_not_optimize(reference[0]);
+                });
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <ctime>
+#include <fstream>
+
+#include "bench_runner.h"
+
+namespace bench {
+
+    static std::string json_escape(const std::string& str) {
+        std::string escaped;
+        for (char c : str) {
+            if (c == '"' || c == '\\') escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string BenchRunner::to_json() const {
+        std::ostringstream out;
+        char timestamp[32];
+        time_t now = time(nullptr);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+        out << "{\n";
+        out << "  \"suite\": \"rtdetr_bench\",\n";
+        out << "  \"timestamp\": \"" << timestamp << "\",\n";
+        out << "  \"build\": {\"compiler\": \"" << json_escape(__VERSION__) << "\", \"opencv\": \""
+            << CV_VERSION << "\"},\n";
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"min_time_ms\": " << m_options.min_time_ms << ",\n";
+        out << "  \"failures\": " << m_failures << ",\n";
+        out << "  \"results\": [";
+        for (size_t i = 0; i < m_results.size(); ++i) {
+            const BenchResult& result = m_results[i];
+            out << (i == 0 ? "\n" : ",\n");
+            out << "    {\"name\": \"" << json_escape(result.name) << "\", \"params\": {";
+            for (size_t j = 0; j < result.params.size(); ++j) {
+                if (j != 0) out << ", ";
+                out << "\"" << json_escape(result.params[j].first) << "\": \""
+                    << json_escape(result.params[j].second) << "\"";
+            }
+            out << "}, \"samples\": " << result.samples
+                << ", \"ops_per_sample\": " << result.ops_per_sample
+                << ", \"mean_us\": " << result.mean_us
+                << ", \"median_us\": " << result.median_us
+                << ", \"min_us\": " << result.min_us
+                << ", \"max_us\": " << result.max_us
+                << ", \"p99_us\": " << result.p99_us << "}";
+        }
+        out << "\n  ]\n}\n";
+        return out.str();
+    }
+}
+
+static void usage() {
+    std::cout << "Usage: rtdetr_bench [--out file.json] [--filter name] [--min-time-ms ms] [--tmp path]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    bench::BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--out") {
+            options.out_file = argv[++i];
+        } else if (i + 1 < argc && arg == "--filter") {
+            options.filter = argv[++i];
+        } else if (i + 1 < argc && arg == "--min-time-ms") {
+            options.min_time_ms = atof(argv[++i]);
+        } else if (i + 1 < argc && arg == "--tmp") {
+            options.tmp_path = argv[++i];
+        } else {
+            usage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+
+    bench::BenchRunner runner(options);
+    bench::bench_cpu_hot_paths(runner);
+    bench::bench_nms(runner);
+    bench::bench_gray_input(runner);
+    bench::bench_uint8_input(runner);
+    bench::bench_half_io(runner);
+    bench::bench_device_letterbox(runner);
+    bench::bench_device_scheduler(runner);
+
+    std::string json = runner.to_json();
+    if (options.out_file.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream out(options.out_file);
+        out << json;
+        out.close();
+        std::cerr << "Write results to " << options.out_file << std::endl;
+    }
+    if (runner.failures() > 0) {
+        std::cerr << runner.failures() << " checks failed." << std::endl;
+        return 1;
+    }
+    return 0;
+}
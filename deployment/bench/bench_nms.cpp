@@ -0,0 +1,92 @@
+#include "bench_runner.h"
+#include "rtdetr_nms.h"
+
+namespace bench {
+
+    // tiled workloads: clusters of duplicated boxes spread over a 4k frame
+    static std::vector<detect_result> synthetic_boxes(int boxes_num, int cls_num, uint32_t seed) {
+        std::vector<detect_result> results;
+        results.reserve(boxes_num);
+        Lcg lcg(seed);
+        const int duplicates = 4;
+        while ((int)results.size() < boxes_num) {
+            float cx = 3840 * lcg.uniform();
+            float cy = 2160 * lcg.uniform();
+            float width = 8 + 120 * lcg.uniform();
+            float height = 8 + 120 * lcg.uniform();
+            int cls = lcg.next() % cls_num;
+            for (int i = 0; i < duplicates && (int)results.size() < boxes_num; ++i) {
+                detect_result result;
+                result.box.width = width * (0.9f + 0.2f * lcg.uniform());
+                result.box.height = height * (0.9f + 0.2f * lcg.uniform());
+                result.box.x = cx - result.box.width / 2 + 4 * (lcg.uniform() - 0.5f);
+                result.box.y = cy - result.box.height / 2 + 4 * (lcg.uniform() - 0.5f);
+                result.score = lcg.uniform();
+                result.cls = cls;
+                result.track_id = -1;
+                results.push_back(result);
+            }
+        }
+        return results;
+    }
+
+    // O(n^2) reference
+    static void naive_nms(std::vector<detect_result>& results, float thresh, bool agnostic, int max_det) {
+        std::stable_sort(results.begin(), results.end(), [](const detect_result& a, const detect_result& b) {
+            return a.score > b.score;
+        });
+        std::vector<detect_result> kept;
+        for (const detect_result& result : results) {
+            if (max_det > 0 && (int)kept.size() >= max_det) break;
+            bool suppressed = false;
+            for (const detect_result& other : kept) {
+                if ((agnostic || other.cls == result.cls) && seeta::box_iou(other.box, result.box) > thresh) {
+                    suppressed = true;
+                    break;
+                }
+            }
+            if (!suppressed) kept.push_back(result);
+        }
+        results.swap(kept);
+    }
+
+    static bool same_results(const std::vector<detect_result>& a, const std::vector<detect_result>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].score != b[i].score || a[i].cls != b[i].cls || a[i].box.x != b[i].box.x) return false;
+        }
+        return true;
+    }
+
+    void bench_nms(BenchRunner& runner) {
+        const float iou_thresh = 0.5f;
+        for (int boxes_num : {300, 2000, 10000}) {
+            for (int agnostic = 0; agnostic <= 1; ++agnostic) {
+                for (int max_det : {0, 20}) {
+                    std::vector<detect_result> boxes = synthetic_boxes(boxes_num, 3, 6);
+                    std::vector<detect_result> results, reference = boxes;
+                    naive_nms(reference, iou_thresh, agnostic != 0, max_det);
+                    results = boxes;
+                    seeta::nms(results, iou_thresh, agnostic != 0, max_det);
+                    if (!same_results(results, reference)) {
+                        runner.fail("grid nms mismatch: " + to_string(results.size()) + " vs " +
+                                    to_string(reference.size()));
+                    }
+
+                    Params params = {{"boxes", to_string(boxes_num)}, {"agnostic", to_string(agnostic)},
+                                    {"max_det", to_string(max_det)}};
+                    runner.run("nms_grid", params, 1, [&]() {
+                        results = boxes;
+                        seeta::nms(results, iou_thresh, agnostic != 0, max_det);
+                        do_not_optimize(results.size());
+                    });
+                    runner.run("nms_naive", params, 1, [&]() {
+                        results = boxes;
+                        naive_nms(results, iou_thresh, agnostic != 0, max_det);
+                        do_not_optimize(results.size());
+                    });
+                }
+            }
+        }
+    }
+}
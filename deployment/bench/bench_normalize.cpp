@@ -0,0 +1,67 @@
+#include <cmath>
+#include <cstring>
+
+#include "bench_runner.h"
+#include "rtdetr_utils.h"
+#include "rtdetr_kernels.h"
+
+namespace bench {
+
+    // uint8 input mode: the host only letterboxes, normalize_cpu is the reference of the device kernel.
+    // bytes is what a frame costs in host, queue and copy memory.
+    void bench_uint8_input(BenchRunner& runner) {
+        const int model_size = 1024;
+        const int plane_size = model_size * model_size;
+        std::vector<float> chw_data(3 * plane_size);
+        std::vector<float> reference(3 * plane_size);
+        std::vector<unsigned char> hwc_data(3 * plane_size);
+
+        for (int channels : {3, 1}) {
+            cv::Mat image = synthetic_image(1920, 1080, channels, 21);
+            float scale_x, scale_y;
+            int padding_top, padding_bottom, padding_left, padding_right;
+
+            // the device arithmetic must match the float preprocess
+            seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                            padding_top, padding_bottom, padding_left, padding_right, true, reference.data());
+            seeta::preprocess_uint8(image, model_size, model_size, scale_x, scale_y,
+                            padding_top, padding_bottom, padding_left, padding_right, true, hwc_data.data());
+            seeta::normalize_cpu(hwc_data.data(), model_size, model_size, channels, chw_data.data());
+            float max_diff = 0.0f;
+            for (size_t i = 0; i < reference.size(); ++i) {
+                max_diff = std::max(max_diff, std::fabs(chw_data[i] - reference[i]));
+            }
+            if (max_diff > 1e-6f) {
+                runner.fail("normalize_cpu mismatch, channels " + to_string(channels) + ", max diff " +
+                            to_string(max_diff));
+            }
+
+            Params params = {{"model_size", to_string(model_size)}, {"channels", to_string(channels)}};
+            params.push_back({"bytes", to_string(3 * plane_size * sizeof(float))});
+            runner.run("input_float_preprocess", params, 1, [&]() {
+                seeta::preprocess(image, model_size, model_size, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, chw_data.data());
+                do_not_optimize(chw_data[0]);
+            });
+            runner.run("input_float_copy", params, 1, [&]() {
+                memcpy(reference.data(), chw_data.data(), chw_data.size() * sizeof(float));
+                do_not_optimize(reference[0]);
+            });
+
+            params.back().second = to_string(channels * plane_size);
+            runner.run("input_uint8_letterbox", params, 1, [&]() {
+                seeta::preprocess_uint8(image, model_size, model_size, scale_x, scale_y,
+                                padding_top, padding_bottom, padding_left, padding_right, true, hwc_data.data());
+                do_not_optimize(hwc_data[0]);
+            });
+            runner.run("input_uint8_copy", params, 1, [&]() {
+                memcpy(chw_data.data(), hwc_data.data(), channels * plane_size);
+                do_not_optimize(chw_data[0]);
+            });
+            runner.run("input_uint8_normalize_cpu", params, 1, [&]() {
+                seeta::normalize_cpu(hwc_data.data(), model_size, model_size, channels, chw_data.data());
+                do_not_optimize(chw_data[0]);
+            });
+        }
+    }
+}
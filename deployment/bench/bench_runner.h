@@ -0,0 +1,189 @@
+#ifndef RTDETR_BENCH_RUNNER_H_
+#define RTDETR_BENCH_RUNNER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "opencv2/core/core.hpp"
+
+namespace bench {
+
+    struct BenchOptions {
+        std::string out_file;       // write json here, stdout if empty
+        std::string filter;         // only run cases whose name contains filter
+        std::string tmp_path = "/tmp";
+        double min_time_ms = 200.0; // minimal measuring time per case
+        int min_samples = 10;
+        int warmup_samples = 3;
+    };
+
+    typedef std::vector<std::pair<std::string, std::string> > Params;
+
+    struct BenchResult {
+        std::string name;
+        Params params;
+        int samples;
+        int ops_per_sample;
+        // all times are per op
+        double mean_us;
+        double median_us;
+        double min_us;
+        double max_us;
+        double p99_us;
+    };
+
+    template <typename T>
+    static std::string to_string(const T& value) {
+        std::ostringstream oss;
+        oss << value;
+        return oss.str();
+    }
+
+    // keep results alive so the compiler can not drop the benchmarked code: the value is read by an
+    // opaque asm statement that may also touch any memory, so a pointer passed here escapes with its buffer
+    template <typename T>
+    static void do_not_optimize(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile uint64_t sink = 0;
+        const unsigned char* bytes = (const unsigned char*)&value;
+        for (size_t i = 0; i < sizeof(T); ++i) sink += bytes[i];
+#endif
+    }
+
+    class BenchRunner {
+        public:
+        explicit BenchRunner(const BenchOptions& options) : m_options(options) {}
+
+        const BenchOptions& options() const {
+            return m_options;
+        }
+
+        bool enabled(const std::string& name) const {
+            return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+        }
+
+        // fn runs ops_per_sample operations, each call is timed as one sample
+        template <typename Func>
+        void run(const std::string& name, const Params& params, int ops_per_sample, Func fn) {
+            if (!enabled(name)) return;
+
+            for (int i = 0; i < m_options.warmup_samples; ++i) {
+                fn();
+            }
+
+            std::vector<double> samples;
+            double total_ms = 0.0;
+            while (total_ms < m_options.min_time_ms || (int)samples.size() < m_options.min_samples) {
+                auto start = std::chrono::high_resolution_clock::now();
+                fn();
+                auto end = std::chrono::high_resolution_clock::now();
+                std::chrono::duration<double, std::micro> duration = end - start;
+                samples.push_back(duration.count() / ops_per_sample);
+                total_ms += duration.count() / 1000.0;
+            }
+            std::sort(samples.begin(), samples.end());
+
+            BenchResult result;
+            result.name = name;
+            result.params = params;
+            result.samples = samples.size();
+            result.ops_per_sample = ops_per_sample;
+            double sum = 0.0;
+            for (double s : samples) sum += s;
+            result.mean_us = sum / samples.size();
+            result.median_us = samples[samples.size() / 2];
+            result.min_us = samples.front();
+            result.max_us = samples.back();
+            result.p99_us = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.99))];
+            m_results.push_back(result);
+
+            std::cerr << name;
+            for (auto& param : params) std::cerr << " " << param.first << "=" << param.second;
+            std::cerr << ": median " << result.median_us << "us, min " << result.min_us
+                    << "us, samples " << result.samples << std::endl;
+        }
+
+        // a correctness check next to a bench failed, rtdetr_bench exits nonzero after the run
+        void fail(const std::string& message) {
+            std::cerr << "FAILED: " << message << std::endl;
+            m_failures++;
+        }
+
+        int failures() const {
+            return m_failures;
+        }
+
+        std::string to_json() const;
+
+        private:
+        BenchOptions m_options;
+        std::vector<BenchResult> m_results;
+        int m_failures = 0;
+    };
+
+    // deterministic pseudo random data, so runs are comparable between builds
+    class Lcg {
+        public:
+        explicit Lcg(uint32_t seed) : m_state(seed) {}
+        uint32_t next() {
+            m_state = m_state * 1664525u + 1013904223u;
+            return m_state;
+        }
+        // [0, 1)
+        float uniform() {
+            return (next() >> 8) * (1.0f / 16777216.0f);
+        }
+        private:
+        uint32_t m_state;
+    };
+
+    static cv::Mat synthetic_image(int width, int height, int channels, uint32_t seed) {
+        cv::Mat image(height, width, CV_8UC(channels));
+        Lcg lcg(seed);
+        for (int h = 0; h < height; ++h) {
+            unsigned char* row = image.ptr<unsigned char>(h);
+            for (int w = 0; w < width * channels; ++w) {
+                row[w] = (unsigned char)(lcg.next() >> 24);
+            }
+        }
+        return image;
+    }
+
+    // raw rtdetr output: num_queries x (4 + cls_num), roughly hit_ratio of queries above 0.5
+    static std::vector<float> synthetic_output(int num_queries, int cls_num, float hit_ratio, uint32_t seed) {
+        std::vector<float> output(num_queries * (4 + cls_num));
+        Lcg lcg(seed);
+        for (int i = 0; i < num_queries; ++i) {
+            float* query = output.data() + i * (4 + cls_num);
+            query[0] = lcg.uniform();
+            query[1] = lcg.uniform();
+            query[2] = 0.01f + 0.2f * lcg.uniform();
+            query[3] = 0.01f + 0.2f * lcg.uniform();
+            bool hit = lcg.uniform() < hit_ratio;
+            for (int j = 0; j < cls_num; ++j) {
+                query[4 + j] = 0.4f * lcg.uniform();
+            }
+            if (hit) query[4 + lcg.next() % cls_num] = 0.5f + 0.5f * lcg.uniform();
+        }
+        return output;
+    }
+
+    // suites
+    void bench_cpu_hot_paths(BenchRunner& runner);
+    void bench_nms(BenchRunner& runner);
+    void bench_gray_input(BenchRunner& runner);
+    void bench_uint8_input(BenchRunner& runner);
+    void bench_half_io(BenchRunner& runner);
+    void bench_device_letterbox(BenchRunner& runner);
+    void bench_device_scheduler(BenchRunner& runner);
+}
+
+#endif // RTDETR_BENCH_RUNNER_H_
@@ -0,0 +1,75 @@
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "bench_runner.h"
+#include "rtdetr_scheduler.h"
+
+namespace bench {
+
+    // simulated device, jobs running together share it: a job takes job_us times the jobs running with it
+    struct MockDevice {
+        int64_t job_us;
+        std::atomic<int> running {0};
+    };
+
+    static void run_mock_job(MockDevice& device) {
+        int running = ++device.running;
+        std::this_thread::sleep_for(std::chrono::microseconds(device.job_us * running));
+        --device.running;
+    }
+
+    // seeta::DeviceScheduler on mock devices of different speeds against round robin routing.
+    // jobs arrive at a fixed rate below the summed speed of the devices; round robin gives the slow
+    // device as many jobs as the fast one and they queue up there. time per op is the time to
+    // finish the burst per job, the mean job latency and the jobs per device go to stderr
+    void bench_device_scheduler(BenchRunner& runner) {
+        if (!runner.enabled("device_scheduler")) return;
+        const int jobs = 120;
+        const int64_t arrival_us = 750;
+        const int devices_num = 3;
+        const int64_t job_us[devices_num] = {1000, 2000, 4000};
+        std::vector<int> devices;
+        for (int i = 0; i < devices_num; ++i) devices.push_back(i);
+        std::vector<int> instance_device = seeta::instance_devices(devices, 2 * devices_num);
+        const int instances = instance_device.size();
+
+        for (bool scheduled : {false, true}) {
+            MockDevice mock[devices_num];
+            for (int i = 0; i < devices_num; ++i) mock[i].job_us = job_us[i];
+            std::unique_ptr<seeta::DeviceScheduler> scheduler(new seeta::DeviceScheduler(instance_device));
+            std::unique_ptr<std::mutex[]> instance_mutex(new std::mutex[instances]);
+            std::atomic<int64_t> latency_us(0);
+            int64_t bursts = 0;
+
+            runner.run("device_scheduler", {{"routing", scheduled ? "least_loaded" : "round_robin"},
+                    {"devices", "1ms,2ms,4ms x2"}, {"arrival_us", to_string(arrival_us)}}, jobs, [&] {
+                auto begin = std::chrono::steady_clock::now();
+                std::vector<std::thread> threads;
+                for (int job = 0; job < jobs; ++job) {
+                    threads.emplace_back([&, job] {
+                        auto arrival = begin + std::chrono::microseconds(job * arrival_us);
+                        std::this_thread::sleep_until(arrival);
+                        if (scheduled) {
+                            int instance = scheduler->acquire();
+                            auto start = std::chrono::steady_clock::now();
+                            run_mock_job(mock[instance_device[instance]]);
+                            scheduler->release(instance, std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start).count());
+                        } else {
+                            std::lock_guard<std::mutex> lock(instance_mutex[job % instances]);
+                            run_mock_job(mock[instance_device[job % instances]]);
+                        }
+                        latency_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - arrival).count();
+                    });
+                }
+                for (std::thread& thread : threads) thread.join();
+                bursts++;
+            });
+            if (bursts > 0) std::cerr << "  mean job latency " << latency_us / 1000.0 / (bursts * jobs) << "ms" << std::endl;
+            if (scheduled) std::cerr << scheduler->report();
+        }
+    }
+}
@@ -8,6 +8,7 @@ extern "C" {
 #include <stdint.h>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgcodecs.hpp"
@@ -16,6 +17,9 @@ extern "C" {
 #include "NvInfer.h"
 using namespace nvinfer1;
 
+#include "rtdetr_kernels.h"
+#include "rtdetr_decode.h"
+
 #define API_EXPORT __attribute__((visibility("default")))
 
 
@@ -31,6 +35,7 @@ struct detect_result {
     bbox box;
     float score;
     int cls;
+    int track_id; // -1 if not tracked
 };
 
 struct detect_result_group {
@@ -38,6 +43,14 @@ struct detect_result_group {
     detect_result* data;
 };
 
+// cut the frame into overlapped tiles for high resolution images
+struct tile_config {
+    int tile_size;      // tile width and height in source pixels, <= 0 means model input size
+    int overlap;        // overlapped pixels between neighbour tiles
+    bool full_frame;    // add the whole frame as one extra tile, for big objects
+    float merge_thresh; // same class boxes overlapped more than thresh (of the smaller box) are merged
+};
+
 namespace seeta {
     
     struct InferDeleter
@@ -58,12 +71,47 @@ namespace seeta {
 
     class Rtdetr {
         public:
-            API_EXPORT Rtdetr(const char* engine_file, float confidence_thresh);
+            // device < 0 is the current cuda device of the calling thread
+            API_EXPORT Rtdetr(const char* engine_file, float confidence_thresh, int device = -1);
             API_EXPORT ~Rtdetr();
 
             API_EXPORT detect_result_group detect(unsigned char* image, int image_width, int image_height, bool debug=false);
+            // hwc uint8 image with 3 (bgr) or 1 (gray) channels
+            API_EXPORT detect_result_group detect(unsigned char* image, int image_width, int image_height, int channels,
+                                            bool debug=false);
             API_EXPORT std::vector<detect_result> detect(float* chw_data, int image_width, int image_height);
+            // jpeg/png/bmp... bytes, decoded into a buffer of this instance that is reused across calls.
+            // imread_flags IMREAD_COLOR or IMREAD_GRAYSCALE. size is -1 if the bytes do not decode
+            API_EXPORT detect_result_group detect_encoded(const uint8_t* bytes, size_t len,
+                                            int imread_flags = cv::IMREAD_COLOR, bool debug=false);
+            // decode buffer allocations of detect_encoded, stops growing after the largest image
+            API_EXPORT int64_t decode_allocations() const;
+            // hwc_data is a letterboxed uint8 image of the model input size (seeta::preprocess_uint8),
+            // normalized on the device. needs set_uint8_input(true)
+            API_EXPORT std::vector<detect_result> detect_letterboxed(const unsigned char* hwc_data, int channels,
+                                            int image_width, int image_height);
+            // tiles are batched into the engine, so engines with batch size > 1 run less passes
+            API_EXPORT detect_result_group detect_tiles(unsigned char* image, int image_width, int image_height, 
+                                            const tile_config& config, bool debug=false);
+            // the same for a hwc uint8 image with 3 (bgr) or 1 (gray) channels
+            API_EXPORT detect_result_group detect_tiles(unsigned char* image, int image_width, int image_height,
+                                            int channels, const tile_config& config, bool debug=false);
+            // images (bgr or gray) share engine passes, up to batch_size() per pass
+            API_EXPORT std::vector<std::vector<detect_result> > detect_batch(const std::vector<cv::Mat>& images);
+            API_EXPORT int batch_size() const;
+            // optional suppression after postprocess, iou_thresh <= 0 disables nms, max_det <= 0 keeps all
+            API_EXPORT void set_nms(float iou_thresh, bool agnostic, int max_det);
+            // upload uint8 images and normalize them on the device, 4x less host memory and copy
+            API_EXPORT void set_uint8_input(bool enable);
+            // upload the source frame and letterbox it on the device into the input binding,
+            // resize, pad, normalize and chw without host preprocessing. see letterbox_cpu for the reference
+            API_EXPORT void set_device_preprocess(bool enable);
             API_EXPORT nvinfer1::Dims input_dims() const;
+            // cuda device of the instance, every call runs on it whatever the device of the calling thread
+            API_EXPORT int device() const;
+            // failed engine executions since construction. their results are empty: size -1 for the
+            // detect_result_group calls, empty vectors otherwise, so callers compare the count around a call
+            API_EXPORT int64_t engine_errors() const;
             API_EXPORT Rtdetr(const Rtdetr&) = delete;
             API_EXPORT Rtdetr(Rtdetr&&) = delete;
             API_EXPORT Rtdetr& operator=(const Rtdetr&) = delete;
@@ -88,9 +136,41 @@ namespace seeta {
             void* m_host_input_mem;
             void* m_host_output_mem;
 
+            // fp16 bindings are detected from the engine, host buffers have the binding type
+            bool m_input_half = false;
+            bool m_output_half = false;
+            std::vector<float> m_output_float; // widened fp16 output
+
+            // uint8 input mode, letterboxed hwc image of one batch slot
+            bool m_uint8_input = false;
+            void* m_cuda_uint8_mem = nullptr;
+            void* m_host_uint8_mem = nullptr;
+
+            // device letterbox mode, source frame and bilinear tables of the last frame size
+            bool m_device_preprocess = false;
+            void* m_cuda_frame_mem = nullptr;
+            size_t m_cuda_frame_size = 0;
+            void* m_cuda_table_mem = nullptr;
+            void* m_host_table_mem = nullptr;
+            size_t m_table_size = 0;
+            letterbox_geometry m_table_geometry = {};
+
+            int m_device = 0;
             float m_conf_thresh;
+            float m_nms_iou_thresh = 0.0f;
+            bool m_nms_agnostic = false;
+            int m_nms_max_det = 0;
             std::vector<detect_result> m_results;
-            
+            DecodeBuffer m_decode_buffer;
+            std::atomic<int64_t> m_engine_errors {0};
+
+            void bind_device();
+            bool execute(void** bindings);
+            void upload_uint8(const unsigned char* hwc_data, int channels);
+            bool infer_and_postprocess(int image_width, int image_height, bool debug);
+            float* float_output(int offset, int size);
+            void preprocess_slot(const cv::Mat& image, int slot);
+            void letterbox_slot(const cv::Mat& image, int slot);
     };
 }
 
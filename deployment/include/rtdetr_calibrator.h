@@ -0,0 +1,140 @@
+#ifndef RTDETR_CALIBRATOR_H_
+#define RTDETR_CALIBRATOR_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "rtdetr.h"
+#include "rtdetr_utils.h"
+
+namespace seeta {
+
+    // calibration batches from an image list, preprocessed like inference (seeta::preprocess).
+    // a producer thread prefetches batches, the stream itself never touches the gpu.
+    class CalibrationStream {
+        public:
+        // max_batches <= 0 uses all images, the last incomplete batch is dropped
+        CalibrationStream(const std::vector<std::string>& images, int batch_size, int input_width, int input_height,
+                        int max_batches = 0, int prefetch = 2)
+            : m_images(images), m_batch_size(batch_size), m_input_width(input_width), m_input_height(input_height),
+              m_prefetch(std::max(1, prefetch)) {
+            m_batches_num = images.size() / batch_size;
+            if (max_batches > 0) m_batches_num = std::min(m_batches_num, max_batches);
+        }
+
+        ~CalibrationStream() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopped = true;
+            }
+            m_cond.notify_all();
+            if (m_producer.joinable()) m_producer.join();
+        }
+
+        CalibrationStream(const CalibrationStream&) = delete;
+        CalibrationStream& operator=(const CalibrationStream&) = delete;
+
+        int batch_size() const { return m_batch_size; }
+        int batches_num() const { return m_batches_num; }
+        // floats of one batch, nchw
+        size_t batch_elems() const { return size_t(m_batch_size) * 3 * m_input_width * m_input_height; }
+
+        // next batch into batch, false when all batches were consumed.
+        // the producer starts with the first call, nothing is read if a calibration cache is used.
+        bool next(std::vector<float>& batch) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_started) {
+                m_started = true;
+                m_producer = std::thread(&CalibrationStream::produce, this);
+            }
+            m_cond.wait(lock, [this] { return !m_batches.empty() || m_produced_done; });
+            if (m_batches.empty()) return false;
+            batch.swap(m_batches.front());
+            m_batches.pop_front();
+            lock.unlock();
+            m_cond.notify_all();
+            return true;
+        }
+
+        private:
+        void produce() {
+            size_t image_idx = 0;
+            size_t image_elems = 3 * m_input_width * m_input_height;
+            for (int b = 0; b < m_batches_num; ++b) {
+                std::vector<float> batch(batch_elems());
+                int filled = 0;
+                // unreadable images are skipped, the batch takes the next ones
+                while (filled < m_batch_size && image_idx < m_images.size()) {
+                    cv::Mat image = cv::imread(m_images[image_idx++]);
+                    if (image.empty()) {
+                        std::cerr << "skip unreadable calibration image " << m_images[image_idx - 1] << std::endl;
+                        continue;
+                    }
+                    float scale_x, scale_y;
+                    int padding_top, padding_bottom, padding_left, padding_right;
+                    seeta::preprocess(image, m_input_width, m_input_height, scale_x, scale_y,
+                                    padding_top, padding_bottom, padding_left, padding_right, true,
+                                    batch.data() + filled * image_elems);
+                    filled++;
+                }
+                if (filled < m_batch_size) break;
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this] { return (int)m_batches.size() < m_prefetch || m_stopped; });
+                if (m_stopped) return;
+                m_batches.push_back(std::move(batch));
+                lock.unlock();
+                m_cond.notify_all();
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_produced_done = true;
+            m_cond.notify_all();
+        }
+
+        std::vector<std::string> m_images;
+        int m_batch_size;
+        int m_input_width;
+        int m_input_height;
+        int m_prefetch;
+        int m_batches_num;
+
+        std::thread m_producer;
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::deque<std::vector<float> > m_batches;
+        bool m_started = false;
+        bool m_produced_done = false;
+        bool m_stopped = false;
+    };
+
+    // entropy calibrator of TensorRT fed by a CalibrationStream. the calibration table is
+    // read from cache_file if it exists and written after calibration, so the images are only
+    // processed once per model.
+    class API_EXPORT Int8Calibrator : public nvinfer1::IInt8EntropyCalibrator2 {
+        public:
+        Int8Calibrator(CalibrationStream& stream, const std::string& cache_file);
+        ~Int8Calibrator();
+
+        Int8Calibrator(const Int8Calibrator&) = delete;
+        Int8Calibrator& operator=(const Int8Calibrator&) = delete;
+
+        int32_t getBatchSize() const noexcept override;
+        bool getBatch(void* bindings[], char const* names[], int32_t nbBindings) noexcept override;
+        void const* readCalibrationCache(size_t& length) noexcept override;
+        void writeCalibrationCache(void const* ptr, size_t length) noexcept override;
+
+        private:
+        CalibrationStream& m_stream;
+        std::string m_cache_file;
+        std::vector<char> m_cache;
+        std::vector<float> m_batch;
+        void* m_cuda_batch_mem = nullptr;
+        int m_batches_done = 0;
+    };
+}
+
+#endif // RTDETR_CALIBRATOR_H_
@@ -0,0 +1,119 @@
+#ifndef RTDETR_DECODE_H_
+#define RTDETR_DECODE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <limits.h>
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+
+namespace seeta {
+
+    static inline uint32_t read_be16(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+    static inline uint32_t read_be32(const uint8_t* p) { return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+    static inline int32_t read_le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+
+    // image size from the header of jpeg, png or bmp bytes, without decoding.
+    // false for other formats or truncated headers
+    static bool encoded_image_size(const uint8_t* bytes, size_t len, int& width, int& height) {
+        static const uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        if (len >= 24 && memcmp(bytes, kPngSignature, 8) == 0 && memcmp(bytes + 12, "IHDR", 4) == 0) {
+            width = read_be32(bytes + 16);
+            height = read_be32(bytes + 20);
+            return width > 0 && height > 0;
+        }
+        if (len >= 26 && bytes[0] == 'B' && bytes[1] == 'M') {
+            width = read_le32(bytes + 18);
+            height = read_le32(bytes + 22);
+            if (height == INT_MIN) return false;
+            height = height < 0 ? -height : height;  // top-down bitmaps
+            return width > 0 && height > 0;
+        }
+        if (len >= 4 && bytes[0] == 0xff && bytes[1] == 0xd8) {
+            // walk the segments up to the start of frame
+            size_t pos = 2;
+            while (pos + 4 <= len) {
+                if (bytes[pos] != 0xff) return false;
+                uint8_t marker = bytes[pos + 1];
+                if (marker == 0xff) {
+                    pos++;  // fill byte
+                    continue;
+                }
+                if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) {
+                    pos += 2;  // no payload
+                    continue;
+                }
+                uint32_t segment = read_be16(bytes + pos + 2);
+                bool frame = marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc;
+                if (frame) {
+                    if (pos + 9 > len) return false;
+                    height = read_be16(bytes + pos + 5);
+                    width = read_be16(bytes + pos + 7);
+                    return width > 0 && height > 0;
+                }
+                pos += 2 + segment;
+            }
+        }
+        return false;
+    }
+
+    // decode target reused across images. it grows to the largest image decoded and never shrinks,
+    // so decoding a stream of images stops allocating once the largest one went through.
+    // the decoded mat is a view of the buffer, valid until the next decode. not thread safe,
+    // one per thread or per engine instance
+    class DecodeBuffer {
+        public:
+        // images of more pixels are not pooled and go to plain imdecode, which rejects them by its
+        // own limit. the default CV_IO_MAX_IMAGE_PIXELS of OpenCV
+        static const size_t kMaxPooledPixels = size_t(1) << 30;
+
+        // bgr (IMREAD_COLOR) or gray (IMREAD_GRAYSCALE) image of the encoded bytes, empty if they do not decode
+        cv::Mat decode(const uint8_t* bytes, size_t len, int imread_flags) {
+            if (len == 0 || len > size_t(INT_MAX)) return cv::Mat();
+            const cv::Mat encoded(1, int(len), CV_8UC1, (void*)bytes);
+            int width, height;
+            bool pooled = (imread_flags == cv::IMREAD_COLOR || imread_flags == cv::IMREAD_GRAYSCALE) &&
+                    encoded_image_size(bytes, len, width, height) &&
+                    size_t(width) * size_t(height) <= kMaxPooledPixels;
+            int channels = imread_flags == cv::IMREAD_GRAYSCALE ? 1 : 3;
+            size_t size = pooled ? size_t(width) * size_t(height) * channels : 0;
+            if (!pooled || size > m_storage.size()) {
+                // header sizes are untrusted: unknown sizes and sizes above the pool go to the fallback
+                // mat, which imdecode releases when the data does not decode. the pool grows only to an
+                // image that decoded, the next one of its size is then written in place
+                unsigned char* data = m_fallback.data;
+                cv::Mat image = cv::imdecode(encoded, imread_flags, &m_fallback);
+                if (!image.empty() && image.data != data) m_allocations++;
+                size_t decoded = image.total() * image.elemSize();
+                if (pooled && image.isContinuous() && decoded > m_storage.size()) {
+                    // up to 3 << 30 bytes, more than the int sizes of a cv::Mat
+                    m_storage.resize(decoded);
+                    m_allocations++;
+                    // the returned image keeps its data, the fallback is not held next to the pool
+                    m_fallback.release();
+                }
+                return image;
+            }
+
+            // imdecode writes in place when the target already has the decoded size and type
+            cv::Mat image(height, width, CV_8UC(channels), m_storage.data());
+            image = cv::imdecode(encoded, imread_flags, &image);
+            // exif rotated jpegs come back in a new mat
+            if (!image.empty() && image.data != m_storage.data()) m_allocations++;
+            return image;
+        }
+
+        // buffer (re)allocations so far, constant in steady state
+        int64_t allocations() const { return m_allocations; }
+
+        private:
+        std::vector<unsigned char> m_storage;
+        cv::Mat m_fallback;
+        int64_t m_allocations = 0;
+    };
+}
+
+#endif // RTDETR_DECODE_H_
@@ -0,0 +1,135 @@
+#ifndef RTDETR_EVAL_H_
+#define RTDETR_EVAL_H_
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "rtdetr.h"
+#include "rtdetr_nms.h"
+
+namespace seeta {
+
+    // detections of one class against ground truth, over all images
+    struct class_matches {
+        int gt_num = 0;
+        std::vector<std::pair<float, bool> > detections;   // score, true positive
+    };
+
+    typedef std::map<int, class_matches> image_matches;     // by class
+
+    // greedy matching per class: detections by descending score take the unmatched
+    // ground truth box of highest iou, if iou >= iou_thresh
+    static image_matches match_image(const std::vector<detect_result>& gt, const std::vector<detect_result>& detections,
+                                    float iou_thresh) {
+        image_matches matches;
+        for (const detect_result& box : gt) matches[box.cls].gt_num++;
+
+        std::vector<int> order(detections.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return detections[a].score > detections[b].score;
+        });
+        std::vector<bool> used(gt.size(), false);
+        for (int i : order) {
+            const detect_result& detection = detections[i];
+            int best = -1;
+            float best_iou = iou_thresh;
+            for (size_t j = 0; j < gt.size(); ++j) {
+                if (used[j] || gt[j].cls != detection.cls) continue;
+                float iou = box_iou(detection.box, gt[j].box);
+                if (iou >= best_iou) {
+                    best_iou = iou;
+                    best = j;
+                }
+            }
+            if (best >= 0) used[best] = true;
+            matches[detection.cls].detections.push_back(std::make_pair(detection.score, best >= 0));
+        }
+        return matches;
+    }
+
+    static void merge_matches(image_matches& total, const image_matches& image) {
+        for (const auto& item : image) {
+            class_matches& matches = total[item.first];
+            matches.gt_num += item.second.gt_num;
+            matches.detections.insert(matches.detections.end(), item.second.detections.begin(),
+                                    item.second.detections.end());
+        }
+    }
+
+    // area under the precision envelope over all recall points (voc 2010+ / coco style without sampling)
+    static float average_precision(class_matches& matches) {
+        if (matches.gt_num == 0) return 0.0f;
+        std::sort(matches.detections.begin(), matches.detections.end(),
+                [](const std::pair<float, bool>& a, const std::pair<float, bool>& b) { return a.first > b.first; });
+        std::vector<float> recall, precision;
+        int tp = 0;
+        for (size_t i = 0; i < matches.detections.size(); ++i) {
+            if (matches.detections[i].second) tp++;
+            recall.push_back(tp * 1.0f / matches.gt_num);
+            precision.push_back(tp * 1.0f / (i + 1));
+        }
+        for (int i = int(precision.size()) - 2; i >= 0; --i) {
+            precision[i] = std::max(precision[i], precision[i + 1]);
+        }
+        float ap = 0.0f, last_recall = 0.0f;
+        for (size_t i = 0; i < recall.size(); ++i) {
+            ap += (recall[i] - last_recall) * precision[i];
+            last_recall = recall[i];
+        }
+        return ap;
+    }
+
+    // what changed for one image between two result sets
+    struct image_diff {
+        int missing = 0;        // boxes of a without a match in b
+        int extra = 0;          // boxes of b without a match in a
+        int score_changed = 0;  // matched, score moved more than score_tol
+        float max_shift = 0.0f; // largest corner shift of matched boxes, pixels
+        float min_iou = 1.0f;   // worst matched iou
+
+        bool changed() const { return missing > 0 || extra > 0 || score_changed > 0; }
+    };
+
+    // boxes of a and b above min_score are matched by class and iou, the leftovers are regressions
+    static image_diff diff_image(const std::vector<detect_result>& a, const std::vector<detect_result>& b,
+                                float min_score, float iou_thresh, float score_tol) {
+        std::vector<detect_result> kept_a, kept_b;
+        for (const detect_result& box : a) if (box.score >= min_score) kept_a.push_back(box);
+        for (const detect_result& box : b) if (box.score >= min_score) kept_b.push_back(box);
+
+        image_diff diff;
+        std::vector<bool> used(kept_b.size(), false);
+        for (const detect_result& box : kept_a) {
+            int best = -1;
+            float best_iou = iou_thresh;
+            for (size_t j = 0; j < kept_b.size(); ++j) {
+                if (used[j] || kept_b[j].cls != box.cls) continue;
+                float iou = box_iou(box.box, kept_b[j].box);
+                if (iou >= best_iou) {
+                    best_iou = iou;
+                    best = j;
+                }
+            }
+            if (best < 0) {
+                diff.missing++;
+                continue;
+            }
+            used[best] = true;
+            const bbox& other = kept_b[best].box;
+            float shift = std::max(std::max(std::fabs(box.box.x - other.x), std::fabs(box.box.y - other.y)),
+                                std::max(std::fabs(box.box.x + box.box.width - other.x - other.width),
+                                        std::fabs(box.box.y + box.box.height - other.y - other.height)));
+            diff.max_shift = std::max(diff.max_shift, shift);
+            diff.min_iou = std::min(diff.min_iou, best_iou);
+            if (std::fabs(box.score - kept_b[best].score) > score_tol) diff.score_changed++;
+        }
+        for (bool matched : used) if (!matched) diff.extra++;
+        return diff;
+    }
+}
+
+#endif // RTDETR_EVAL_H_
@@ -0,0 +1,144 @@
+#ifndef RTDETR_HALF_H_
+#define RTDETR_HALF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// F16C is compiled into its own functions and chosen at run time, the rest of the build keeps
+// the baseline instruction set and runs on cpus without it
+#if defined(RTDETR_USE_F16C) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+        !defined(__CUDACC__)
+#define RTDETR_HALF_F16C 1
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+namespace seeta {
+
+    // ieee binary16 <-> binary32 for engines with fp16 input/output bindings.
+    // F16C converts 8 values per instruction, the scalar versions cover the tails and other cpus.
+
+    // round to nearest even, like _mm256_cvtps_ph
+    static inline uint16_t float_to_half_scalar(float value) {
+        uint32_t x;
+        memcpy(&x, &value, sizeof(x));
+        uint16_t sign = (x >> 16) & 0x8000;
+        uint32_t mantissa = x & 0x7fffff;
+        int exponent = (x >> 23) & 0xff;
+        if (exponent == 0xff) {
+            // inf or nan
+            return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+        }
+        int half_exponent = exponent - 127 + 15;
+        if (half_exponent >= 0x1f) return sign | 0x7c00;
+        if (half_exponent <= 0) {
+            // subnormal half or zero
+            if (half_exponent < -10) return sign;
+            mantissa |= 0x800000;
+            int shift = 14 - half_exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t middle = 1u << (shift - 1);
+            if (rest > middle || (rest == middle && (half & 1))) half++;
+            return sign | half;
+        }
+        uint32_t half = (half_exponent << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        // a carry into the exponent is still the right result, up to inf
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+        return sign | half;
+    }
+
+    static inline float half_to_float_scalar(uint16_t half) {
+        uint32_t sign = uint32_t(half & 0x8000) << 16;
+        uint32_t exponent = (half >> 10) & 0x1f;
+        uint32_t mantissa = half & 0x3ff;
+        uint32_t x;
+        if (exponent == 0) {
+            if (mantissa == 0) {
+                x = sign;
+            } else {
+                // subnormal half is a normal float
+                exponent = 127 - 15 + 1;
+                while (!(mantissa & 0x400)) {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                x = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+            }
+        } else if (exponent == 0x1f) {
+            x = sign | 0x7f800000 | (mantissa << 13);
+        } else {
+            x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+        float value;
+        memcpy(&value, &x, sizeof(value));
+        return value;
+    }
+
+#ifdef RTDETR_HALF_F16C
+    // avx with os support for the ymm state, and the f16c bit of cpuid leaf 1
+    static bool cpu_has_f16c() {
+        static const bool supported = []() {
+            unsigned int eax, ebx, ecx, edx;
+            return __builtin_cpu_supports("avx") && __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C);
+        }();
+        return supported;
+    }
+
+    // whole blocks of 8, returns the count converted
+    __attribute__((target("avx,f16c")))
+    static size_t float_to_half_f16c(const float* src, uint16_t* dst, size_t size, float scale) {
+        const __m256 scale_vec = _mm256_set1_ps(scale);
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            __m256 values = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale_vec);
+            _mm_storeu_si128((__m128i*)(dst + i), _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx,f16c")))
+    static size_t half_to_float_f16c(const uint16_t* src, float* dst, size_t size) {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+        }
+        return i;
+    }
+#endif
+
+    // dst[i] = half(src[i] * scale)
+    static void float_to_half(const float* src, uint16_t* dst, size_t size, float scale = 1.0f) {
+        size_t i = 0;
+#ifdef RTDETR_HALF_F16C
+        if (cpu_has_f16c()) i = float_to_half_f16c(src, dst, size, scale);
+#endif
+        for (; i < size; ++i) {
+            dst[i] = float_to_half_scalar(src[i] * scale);
+        }
+    }
+
+    static void half_to_float(const uint16_t* src, float* dst, size_t size) {
+        size_t i = 0;
+#ifdef RTDETR_HALF_F16C
+        if (cpu_has_f16c()) i = half_to_float_f16c(src, dst, size);
+#endif
+        for (; i < size; ++i) {
+            dst[i] = half_to_float_scalar(src[i]);
+        }
+    }
+
+    // uint8 row to half with scale, through a small float block that stays in registers
+    static void uint8_to_half(const uint8_t* src, uint16_t* dst, size_t size, float scale) {
+        float block[64];
+        for (size_t begin = 0; begin < size; begin += 64) {
+            size_t count = size - begin < 64 ? size - begin : 64;
+            for (size_t i = 0; i < count; ++i) block[i] = src[begin + i];
+            float_to_half(block, dst + begin, count, scale);
+        }
+    }
+}
+
+#endif // RTDETR_HALF_H_
@@ -0,0 +1,219 @@
+#ifndef RTDETR_KERNELS_H_
+#define RTDETR_KERNELS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#include <cuda_runtime_api.h>
+
+#include "rtdetr_half.h"
+
+#if defined(__CUDACC__)
+#define RTDETR_HOST_DEVICE __host__ __device__
+#else
+#define RTDETR_HOST_DEVICE
+#endif
+
+namespace seeta {
+
+    // one pixel of the letterboxed uint8 hwc image (bgr or gray) to normalized rgb.
+    // shared by the device kernels and the cpu references, so both do the same arithmetic.
+    RTDETR_HOST_DEVICE inline void normalize_pixel(const uint8_t* hwc_data, int channels, int index, float* rgb) {
+        const float scale = 1.0f / 255.0f;
+        if (channels == 1) {
+            rgb[0] = rgb[1] = rgb[2] = hwc_data[index] * scale;
+            return;
+        }
+        // bgr to rgb
+        const uint8_t* pixel = hwc_data + index * 3;
+        rgb[0] = pixel[2] * scale;
+        rgb[1] = pixel[1] * scale;
+        rgb[2] = pixel[0] * scale;
+    }
+
+    // cpu reference of normalize_gpu
+    inline void normalize_cpu(const uint8_t* hwc_data, int width, int height, int channels, float* chw_data) {
+        int plane_size = width * height;
+        float rgb[3];
+        for (int i = 0; i < plane_size; ++i) {
+            normalize_pixel(hwc_data, channels, i, rgb);
+            chw_data[i] = rgb[0];
+            chw_data[plane_size + i] = rgb[1];
+            chw_data[2 * plane_size + i] = rgb[2];
+        }
+    }
+
+    // cpu reference of normalize_half_gpu, fp16 bits
+    inline void normalize_half_cpu(const uint8_t* hwc_data, int width, int height, int channels, uint16_t* chw_data) {
+        int plane_size = width * height;
+        float rgb[3];
+        for (int i = 0; i < plane_size; ++i) {
+            normalize_pixel(hwc_data, channels, i, rgb);
+            chw_data[i] = float_to_half_scalar(rgb[0]);
+            chw_data[plane_size + i] = float_to_half_scalar(rgb[1]);
+            chw_data[2 * plane_size + i] = float_to_half_scalar(rgb[2]);
+        }
+    }
+
+    // letterbox of a source frame into the model input, see seeta::letter_box.
+    // the resized area starts at (pad_left, pad_top), the rest is filled with 114.
+    struct letterbox_geometry {
+        int src_width;
+        int src_height;
+        int channels;           // 3 (bgr) or 1 (gray)
+        int dst_width;          // model input
+        int dst_height;
+        int resized_width;
+        int resized_height;
+        int pad_left;
+        int pad_top;
+
+        bool operator==(const letterbox_geometry& other) const {
+            return src_width == other.src_width && src_height == other.src_height && channels == other.channels &&
+                dst_width == other.dst_width && dst_height == other.dst_height &&
+                resized_width == other.resized_width && resized_height == other.resized_height &&
+                pad_left == other.pad_left && pad_top == other.pad_top;
+        }
+    };
+
+    // bilinear taps of the resized area in the fixed point of cv::resize INTER_LINEAR on uint8:
+    // source pixel of the first tap and two coefficients summing to 2048 per column and row
+    struct letterbox_tables {
+        const int* x_offsets;       // resized_width
+        const int* y_offsets;       // resized_height
+        const int16_t* x_coefs;     // 2 * resized_width
+        const int16_t* y_coefs;     // 2 * resized_height
+    };
+
+    const int kLetterboxCoefBits = 11;
+    const uint8_t kLetterboxPadValue = 114;
+
+    // bytes of the tables, laid out x_offsets, y_offsets, x_coefs, y_coefs
+    inline size_t letterbox_tables_size(const letterbox_geometry& geometry) {
+        return (geometry.resized_width + geometry.resized_height) * (sizeof(int) + 2 * sizeof(int16_t));
+    }
+
+    // the tables inside a host or device buffer of letterbox_tables_size
+    inline letterbox_tables letterbox_tables_at(const letterbox_geometry& geometry, const void* buffer) {
+        letterbox_tables tables;
+        tables.x_offsets = (const int*)buffer;
+        tables.y_offsets = tables.x_offsets + geometry.resized_width;
+        tables.x_coefs = (const int16_t*)(tables.y_offsets + geometry.resized_height);
+        tables.y_coefs = tables.x_coefs + 2 * geometry.resized_width;
+        return tables;
+    }
+
+    // taps of one axis, the mapping of cv::resize: half pixel centers. cv::resize clamps the columns
+    // with their coefficients, but the rows only by index: the first row tap of an upscale can be -1
+    // or src_size - 1 with its fraction kept, letterbox_pixel clamps both rows into the frame
+    inline void letterbox_axis(int src_size, int resized_size, bool clamp_coefs, int* offsets, int16_t* coefs) {
+        double scale = 1.0 / ((double)resized_size / src_size);
+        for (int d = 0; d < resized_size; ++d) {
+            float f = (float)((d + 0.5) * scale - 0.5);
+            int s = (int)floorf(f);
+            f -= s;
+            if (clamp_coefs && s < 0) {
+                f = 0.0f;
+                s = 0;
+            }
+            if (clamp_coefs && s >= src_size - 1) {
+                f = 0.0f;
+                s = src_size - 1;
+            }
+            offsets[d] = s;
+            coefs[2 * d] = (int16_t)lrintf((1.0f - f) * (1 << kLetterboxCoefBits));
+            coefs[2 * d + 1] = (int16_t)lrintf(f * (1 << kLetterboxCoefBits));
+        }
+    }
+
+    // computed on the host once per frame size, the kernels only do integer arithmetic on them
+    inline letterbox_tables build_letterbox_tables(const letterbox_geometry& geometry, void* buffer) {
+        letterbox_tables tables = letterbox_tables_at(geometry, buffer);
+        letterbox_axis(geometry.src_width, geometry.resized_width, true,
+                    (int*)tables.x_offsets, (int16_t*)tables.x_coefs);
+        letterbox_axis(geometry.src_height, geometry.resized_height, false,
+                    (int*)tables.y_offsets, (int16_t*)tables.y_coefs);
+        return tables;
+    }
+
+    // one pixel of the model input from the source frame, resized, padded and normalized to rgb.
+    // shared by letterbox_gpu and letterbox_cpu, integer taps so both give the same bits.
+    // the rounding is the one of cv::resize INTER_LINEAR on uint8 (VResizeLinear with FixedPtCast):
+    // the horizontal sums drop 4 bits, each vertical product drops 16, and the sum is rounded by 2 bits
+    RTDETR_HOST_DEVICE inline void letterbox_pixel(const uint8_t* src, int src_step, const letterbox_geometry& geometry,
+                                                const letterbox_tables& tables, int x, int y, float* rgb) {
+        uint8_t value[3] = {kLetterboxPadValue, kLetterboxPadValue, kLetterboxPadValue};
+        int rx = x - geometry.pad_left;
+        int ry = y - geometry.pad_top;
+        int channels = geometry.channels;
+        if (rx >= 0 && ry >= 0 && rx < geometry.resized_width && ry < geometry.resized_height) {
+            int sx0 = tables.x_offsets[rx];
+            int sx1 = sx0 + 1 < geometry.src_width ? sx0 + 1 : sx0;
+            int sy0 = tables.y_offsets[ry];
+            int sy1 = sy0 + 1 < geometry.src_height ? sy0 + 1 : geometry.src_height - 1;
+            sy0 = sy0 < 0 ? 0 : sy0;
+            int x_coef0 = tables.x_coefs[2 * rx], x_coef1 = tables.x_coefs[2 * rx + 1];
+            int y_coef0 = tables.y_coefs[2 * ry], y_coef1 = tables.y_coefs[2 * ry + 1];
+            const uint8_t* row0 = src + (size_t)sy0 * src_step;
+            const uint8_t* row1 = src + (size_t)sy1 * src_step;
+            for (int c = 0; c < channels; ++c) {
+                int top = row0[sx0 * channels + c] * x_coef0 + row0[sx1 * channels + c] * x_coef1;
+                int bottom = row1[sx0 * channels + c] * x_coef0 + row1[sx1 * channels + c] * x_coef1;
+                value[c] = (uint8_t)((((y_coef0 * (top >> 4)) >> 16) + ((y_coef1 * (bottom >> 4)) >> 16) + 2) >> 2);
+            }
+        }
+        normalize_pixel(value, channels, 0, rgb);
+    }
+
+    // cpu reference of letterbox_gpu, src is the hwc frame with rows src_step bytes apart
+    inline void letterbox_cpu(const uint8_t* src, int src_step, const letterbox_geometry& geometry,
+                            const letterbox_tables& tables, float* chw_data) {
+        int plane_size = geometry.dst_width * geometry.dst_height;
+        float rgb[3];
+        for (int y = 0; y < geometry.dst_height; ++y) {
+            for (int x = 0; x < geometry.dst_width; ++x) {
+                int i = y * geometry.dst_width + x;
+                letterbox_pixel(src, src_step, geometry, tables, x, y, rgb);
+                chw_data[i] = rgb[0];
+                chw_data[plane_size + i] = rgb[1];
+                chw_data[2 * plane_size + i] = rgb[2];
+            }
+        }
+    }
+
+    // cpu reference of letterbox_half_gpu, fp16 bits
+    inline void letterbox_half_cpu(const uint8_t* src, int src_step, const letterbox_geometry& geometry,
+                                const letterbox_tables& tables, uint16_t* chw_data) {
+        int plane_size = geometry.dst_width * geometry.dst_height;
+        float rgb[3];
+        for (int y = 0; y < geometry.dst_height; ++y) {
+            for (int x = 0; x < geometry.dst_width; ++x) {
+                int i = y * geometry.dst_width + x;
+                letterbox_pixel(src, src_step, geometry, tables, x, y, rgb);
+                chw_data[i] = float_to_half_scalar(rgb[0]);
+                chw_data[plane_size + i] = float_to_half_scalar(rgb[1]);
+                chw_data[2 * plane_size + i] = float_to_half_scalar(rgb[2]);
+            }
+        }
+    }
+
+    // device buffers: uint8 hwc image in, float rgb chw planes out, asynchronous on stream
+    void normalize_gpu(const uint8_t* cuda_hwc_data, int width, int height, int channels, float* cuda_chw_data,
+                    cudaStream_t stream = 0);
+
+    // the same for engines with a fp16 input binding
+    void normalize_half_gpu(const uint8_t* cuda_hwc_data, int width, int height, int channels, uint16_t* cuda_chw_data,
+                    cudaStream_t stream = 0);
+
+    // device buffers: source frame, tables (letterbox_tables_at a device copy), float rgb chw planes
+    // of the model input out. resize, pad and normalize in one pass, asynchronous on stream
+    void letterbox_gpu(const uint8_t* cuda_src, int src_step, const letterbox_geometry& geometry,
+                    const letterbox_tables& cuda_tables, float* cuda_chw_data, cudaStream_t stream = 0);
+
+    // the same for engines with a fp16 input binding
+    void letterbox_half_gpu(const uint8_t* cuda_src, int src_step, const letterbox_geometry& geometry,
+                    const letterbox_tables& cuda_tables, uint16_t* cuda_chw_data, cudaStream_t stream = 0);
+}
+
+#endif // RTDETR_KERNELS_H_
@@ -0,0 +1,137 @@
+#ifndef RTDETR_MOTION_H_
+#define RTDETR_MOTION_H_
+
+#include <stdint.h>
+#include <algorithm>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgproc.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace seeta {
+
+    struct motion_config {
+        int width = 160;                // frames are compared on a gray thumbnail of this width
+        int pixel_thresh = 12;          // gray level difference of a changed pixel
+        float changed_ratio = 0.001f;   // frame is changed if more thumbnail pixels changed
+        int region_margin = 2;          // thumbnail pixels added around the changed region
+    };
+
+    struct motion_result {
+        bool changed;
+        float changed_ratio;
+        cv::Rect region;                // changed region in frame coordinates, whole frame without reference
+    };
+
+    // number of pixels with |a - b| > thresh, first and last changed column are updated
+    static int count_changed(const uint8_t* a, const uint8_t* b, int size, uint8_t thresh, int& first, int& last) {
+        int changed = 0;
+        int i = 0;
+#if defined(__SSE2__)
+        const __m128i thresh_vec = _mm_set1_epi8((char)thresh);
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= size; i += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+            // |a - b| with saturated subtraction, then > thresh
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+            __m128i over = _mm_subs_epu8(diff, thresh_vec);
+            int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(over, zero)) & 0xFFFF;
+            if (mask) {
+                changed += __builtin_popcount(mask);
+                first = std::min(first, i + __builtin_ctz(mask));
+                last = std::max(last, i + 31 - __builtin_clz(mask));
+            }
+        }
+#endif
+        for (; i < size; ++i) {
+            int diff = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+            if (diff > thresh) {
+                changed++;
+                first = std::min(first, i);
+                last = std::max(last, i);
+            }
+        }
+        return changed;
+    }
+
+    // cheap frame difference gate for static cameras, frames without changes against the
+    // reference (the last inferred frame) can reuse its detections.
+    class MotionGate {
+        public:
+        explicit MotionGate(const motion_config& config = motion_config()) : m_config(config) {}
+
+        motion_result check(const cv::Mat& frame) {
+            motion_result result;
+            if (frame.empty()) {
+                // nothing to compare, the reference stays
+                result.changed = false;
+                result.changed_ratio = 0.0f;
+                return result;
+            }
+            int width = std::min(m_config.width, frame.cols);
+            int height = std::max(1, frame.rows * width / frame.cols);
+            cv::Mat small;
+            cv::resize(frame, small, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+            if (small.channels() == 3) {
+                cv::cvtColor(small, m_current, cv::COLOR_BGR2GRAY);
+            } else {
+                m_current = small;
+            }
+
+            if (m_reference.empty() || m_reference.size().width != width || m_reference.size().height != height) {
+                result.changed = true;
+                result.changed_ratio = 1.0f;
+                result.region = cv::Rect(0, 0, frame.cols, frame.rows);
+                return result;
+            }
+
+            int changed = 0;
+            int left = width, right = -1, top = height, bottom = -1;
+            for (int h = 0; h < height; ++h) {
+                int first = width, last = -1;
+                changed += count_changed(m_current.ptr<uint8_t>(h), m_reference.ptr<uint8_t>(h), width,
+                                (uint8_t)m_config.pixel_thresh, first, last);
+                if (last >= 0) {
+                    left = std::min(left, first);
+                    right = std::max(right, last);
+                    top = std::min(top, h);
+                    bottom = h;
+                }
+            }
+
+            result.changed_ratio = changed * 1.0f / (width * height);
+            result.changed = result.changed_ratio > m_config.changed_ratio;
+            if (right < 0) {
+                result.region = cv::Rect();
+                return result;
+            }
+
+            // thumbnail to frame coordinates
+            float scale_x = frame.cols * 1.0f / width;
+            float scale_y = frame.rows * 1.0f / height;
+            int margin = m_config.region_margin;
+            int x1 = std::max(0, int((left - margin) * scale_x));
+            int y1 = std::max(0, int((top - margin) * scale_y));
+            int x2 = std::min(frame.cols, int((right + 1 + margin) * scale_x + 0.5f));
+            int y2 = std::min(frame.rows, int((bottom + 1 + margin) * scale_y + 0.5f));
+            result.region = cv::Rect(x1, y1, x2 - x1, y2 - y1);
+            return result;
+        }
+
+        // the checked frame was inferred, later frames are compared with it
+        void accept() {
+            m_reference = m_current.clone();
+        }
+
+        private:
+        motion_config m_config;
+        cv::Mat m_current;
+        cv::Mat m_reference;
+    };
+}
+
+#endif // RTDETR_MOTION_H_
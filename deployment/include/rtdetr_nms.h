@@ -0,0 +1,169 @@
+#ifndef RTDETR_NMS_H_
+#define RTDETR_NMS_H_
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "rtdetr.h"
+
+namespace seeta {
+
+    enum nms_metric {
+        NMS_IOU = 0,    // intersection over union
+        NMS_IOS = 1,    // intersection over the smaller box
+    };
+
+    static float box_overlap(const bbox& a, const bbox& b, nms_metric metric) {
+        float x1 = std::max(a.x, b.x);
+        float y1 = std::max(a.y, b.y);
+        float x2 = std::min(a.x + a.width, b.x + b.width);
+        float y2 = std::min(a.y + a.height, b.y + b.height);
+        if (x2 <= x1 || y2 <= y1) return 0.0f;
+        float inter = (x2 - x1) * (y2 - y1);
+        float area_a = a.width * a.height;
+        float area_b = b.width * b.height;
+        float denominator = metric == NMS_IOU ? area_a + area_b - inter : std::min(area_a, area_b);
+        return denominator > 0 ? inter / denominator : 0.0f;
+    }
+
+    static float box_iou(const bbox& a, const bbox& b) {
+        return box_overlap(a, b, NMS_IOU);
+    }
+
+    // uniform grid over the boxes extent, kept boxes are registered in every cell they touch,
+    // so a candidate is only compared with kept boxes nearby instead of all of them.
+    class NmsGrid {
+        public:
+        NmsGrid(const std::vector<detect_result>& results, int max_cells_per_side = 64) {
+            float min_x = results[0].box.x, min_y = results[0].box.y;
+            float max_x = min_x, max_y = min_y;
+            double extent = 0.0;
+            for (const detect_result& result : results) {
+                min_x = std::min(min_x, result.box.x);
+                min_y = std::min(min_y, result.box.y);
+                max_x = std::max(max_x, result.box.x + result.box.width);
+                max_y = std::max(max_y, result.box.y + result.box.height);
+                extent += std::max(result.box.width, result.box.height);
+            }
+            // cells about the size of an average box, each box touches few cells
+            float cell = std::max(1.0f, float(extent / results.size()));
+            cell = std::max(cell, std::max(max_x - min_x, max_y - min_y) / max_cells_per_side);
+            m_origin_x = min_x;
+            m_origin_y = min_y;
+            m_cell = cell;
+            m_cols = std::max(1, int(std::ceil((max_x - min_x) / cell)));
+            m_rows = std::max(1, int(std::ceil((max_y - min_y) / cell)));
+            m_cells.resize(m_cols * m_rows);
+        }
+
+        // cells range covered by box, inclusive
+        void cells(const bbox& box, int& col_begin, int& col_end, int& row_begin, int& row_end) const {
+            col_begin = clamp_col(int((box.x - m_origin_x) / m_cell));
+            col_end = clamp_col(int((box.x + box.width - m_origin_x) / m_cell));
+            row_begin = clamp_row(int((box.y - m_origin_y) / m_cell));
+            row_end = clamp_row(int((box.y + box.height - m_origin_y) / m_cell));
+        }
+
+        void insert(const bbox& box, int id) {
+            int col_begin, col_end, row_begin, row_end;
+            cells(box, col_begin, col_end, row_begin, row_end);
+            for (int row = row_begin; row <= row_end; ++row) {
+                for (int col = col_begin; col <= col_end; ++col) {
+                    m_cells[row * m_cols + col].push_back(id);
+                }
+            }
+        }
+
+        const std::vector<int>& cell(int col, int row) const {
+            return m_cells[row * m_cols + col];
+        }
+
+        private:
+        int clamp_col(int col) const { return std::min(std::max(col, 0), m_cols - 1); }
+        int clamp_row(int row) const { return std::min(std::max(row, 0), m_rows - 1); }
+
+        float m_origin_x;
+        float m_origin_y;
+        float m_cell;
+        int m_cols;
+        int m_rows;
+        std::vector<std::vector<int> > m_cells;
+    };
+
+    // greedy non-maximum suppression, results are sorted by score when finished.
+    // thresh <= 0 disables suppression, max_det <= 0 keeps all boxes.
+    // candidates are popped from a heap, so only the top boxes up to max_det are ordered.
+    // keep_larger gives a kept box the extent of a larger box it suppresses, its score stays
+    static void nms(std::vector<detect_result>& results, float thresh, bool agnostic, int max_det,
+                    nms_metric metric = NMS_IOU, bool keep_larger = false)
+    {
+        int limit = max_det > 0 ? std::min<int>(max_det, results.size()) : results.size();
+        auto greater_score = [](const detect_result& a, const detect_result& b) {
+            return a.score > b.score;
+        };
+
+        if (thresh <= 0 || results.size() <= 1) {
+            // top-k only
+            std::partial_sort(results.begin(), results.begin() + limit, results.end(), greater_score);
+            results.resize(limit);
+            return;
+        }
+
+        // no more cells than boxes, building the grid must stay cheaper than the saved comparisons
+        NmsGrid grid(results, std::min(64, int(std::sqrt(float(results.size()))) + 1));
+        std::vector<int> order(results.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        auto lower_score = [&results](int a, int b) {
+            return results[a].score < results[b].score;
+        };
+        std::make_heap(order.begin(), order.end(), lower_score);
+
+        std::vector<detect_result> kept;
+        kept.reserve(limit);
+        // a kept box may be registered in several cells, visit it once per candidate
+        std::vector<int> visited;
+        int candidate_id = 0;
+        for (auto heap_end = order.end(); heap_end != order.begin() && int(kept.size()) < limit; --heap_end) {
+            std::pop_heap(order.begin(), heap_end, lower_score);
+            const detect_result& candidate = results[*(heap_end - 1)];
+            candidate_id++;
+
+            bool suppressed = false;
+            int suppressor = -1;
+            int col_begin, col_end, row_begin, row_end;
+            grid.cells(candidate.box, col_begin, col_end, row_begin, row_end);
+            for (int row = row_begin; row <= row_end && !suppressed; ++row) {
+                for (int col = col_begin; col <= col_end && !suppressed; ++col) {
+                    for (int id : grid.cell(col, row)) {
+                        if (visited[id] == candidate_id) continue;
+                        visited[id] = candidate_id;
+                        const detect_result& other = kept[id];
+                        if ((agnostic || other.cls == candidate.cls) &&
+                                box_overlap(other.box, candidate.box, metric) > thresh) {
+                            suppressed = true;
+                            suppressor = id;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (!suppressed) {
+                grid.insert(candidate.box, kept.size());
+                kept.push_back(candidate);
+                visited.push_back(0);
+            } else if (keep_larger) {
+                bbox& box = kept[suppressor].box;
+                if (candidate.box.width * candidate.box.height > box.width * box.height) {
+                    box = candidate.box;
+                    // the cells of the old extent stay, visited skips the repeats
+                    grid.insert(box, suppressor);
+                }
+            }
+        }
+        results.swap(kept);
+    }
+}
+
+#endif // RTDETR_NMS_H_
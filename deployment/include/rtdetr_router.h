@@ -0,0 +1,158 @@
+#ifndef RTDETR_ROUTER_H_
+#define RTDETR_ROUTER_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <mutex>
+#include <algorithm>
+
+namespace seeta {
+
+    // "a640.engine,b1024.engine" -> {"a640.engine", "b1024.engine"}
+    static std::vector<std::string> parse_models(const std::string& models) {
+        std::vector<std::string> result;
+        std::stringstream items(models);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            size_t begin = item.find_first_not_of(" \t");
+            size_t end = item.find_last_not_of(" \t");
+            if (begin != std::string::npos) result.push_back(item.substr(begin, end - begin + 1));
+        }
+        return result;
+    }
+
+    // picks the engine of a frame among engines of different input resolutions. the largest
+    // engine is preferred; a frame degrades to the next smaller one when the queue of the larger
+    // is max_queue_depth deep, or when the larger is expected to miss the latency slo:
+    // (queued frames + 1) x its recent latency per queued frame. a drained queue brings the
+    // larger engine back. a request hint (an input size) overrides the load and takes the engine
+    // of the closest resolution. no cuda in here, like DeviceScheduler
+    class ResolutionRouter {
+        public:
+        struct EngineStats {
+            int resolution;
+            int64_t frames;
+            int64_t hinted;         // frames routed by a request hint
+            int64_t degraded;       // frames that would have gone to a larger engine without the load
+            int64_t latency_sum_us;
+            double service_us;      // recent latency per frame queued in front, moving average
+        };
+
+        // max_queue_depth <= 0 and slo_us <= 0 disable the respective check
+        ResolutionRouter(const std::vector<int>& resolutions, int max_queue_depth, int64_t slo_us)
+            : m_max_queue_depth(max_queue_depth), m_slo_us(slo_us) {
+            for (int resolution : resolutions) {
+                Engine engine;
+                engine.stats.resolution = resolution;
+                m_engines.push_back(engine);
+            }
+            m_order.resize(m_engines.size());
+            for (size_t i = 0; i < m_order.size(); ++i) m_order[i] = int(i);
+            std::stable_sort(m_order.begin(), m_order.end(), [this](int a, int b) {
+                return m_engines[a].stats.resolution > m_engines[b].stats.resolution;
+            });
+        }
+
+        // engine of the next frame, hint 0 lets the load decide. every route is followed by a done
+        int route(int hint, int& queued_ahead) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int chosen = hint > 0 ? closest(hint) : by_load();
+            Engine& engine = m_engines[chosen];
+            if (hint > 0) engine.stats.hinted++;
+            else if (chosen != m_order[0]) engine.stats.degraded++;
+            queued_ahead = engine.queued;
+            engine.queued++;
+            engine.stats.frames++;
+            return chosen;
+        }
+
+        // the frame finished, latency_us from route to done, queued_ahead as returned by route
+        void done(int index, int queued_ahead, int64_t latency_us) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Engine& engine = m_engines[index];
+            engine.queued--;
+            engine.stats.latency_sum_us += latency_us;
+            double service_us = latency_us / double(queued_ahead + 1);
+            engine.stats.service_us = engine.stats.service_us > 0.0
+                ? engine.stats.service_us * (1.0 - kServiceWeight) + service_us * kServiceWeight
+                : service_us;
+        }
+
+        int queued() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int queued = 0;
+            for (const Engine& engine : m_engines) queued += engine.queued;
+            return queued;
+        }
+
+        std::vector<EngineStats> stats() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<EngineStats> result;
+            for (const Engine& engine : m_engines) result.push_back(engine.stats);
+            return result;
+        }
+
+        // frames and mean latency per resolution, e.g.
+        // {"640": {"frames": 10, "share": 0.5, "hinted": 0, "degraded": 10, "mean_latency_us": 900}, ...}
+        std::string to_json() {
+            std::vector<EngineStats> engines = stats();
+            int64_t frames = 0;
+            for (const EngineStats& engine : engines) frames += engine.frames;
+            std::ostringstream out;
+            out << "{";
+            for (size_t i = 0; i < engines.size(); ++i) {
+                const EngineStats& engine = engines[i];
+                out << (i ? ", " : "") << "\"" << engine.resolution << "\": {\"frames\": " << engine.frames
+                    << ", \"share\": " << (frames ? engine.frames * 1.0 / frames : 0.0)
+                    << ", \"hinted\": " << engine.hinted << ", \"degraded\": " << engine.degraded
+                    << ", \"mean_latency_us\": " << (engine.frames ? engine.latency_sum_us / engine.frames : 0) << "}";
+            }
+            out << "}";
+            return out.str();
+        }
+
+        private:
+        static constexpr double kServiceWeight = 0.1;
+
+        struct Engine {
+            EngineStats stats = {0, 0, 0, 0, 0, 0.0};
+            int queued = 0;
+        };
+
+        // the first engine from large to small within depth and slo, the smallest if none is.
+        // an idle engine is always within the slo: its estimate only changes by the frames it gets,
+        // one slow frame would otherwise keep it out for good
+        int by_load() const {
+            for (size_t i = 0; i + 1 < m_order.size(); ++i) {
+                const Engine& engine = m_engines[m_order[i]];
+                if (m_max_queue_depth > 0 && engine.queued >= m_max_queue_depth) continue;
+                if (m_slo_us > 0 && engine.queued > 0 && (engine.queued + 1) * engine.stats.service_us > m_slo_us) {
+                    continue;
+                }
+                return m_order[i];
+            }
+            return m_order.back();
+        }
+
+        int closest(int hint) const {
+            int best = m_order[0];
+            for (int index : m_order) {
+                if (abs(m_engines[index].stats.resolution - hint) < abs(m_engines[best].stats.resolution - hint)) {
+                    best = index;
+                }
+            }
+            return best;
+        }
+
+        int m_max_queue_depth;
+        int64_t m_slo_us;
+        std::mutex m_mutex;
+        std::vector<Engine> m_engines;
+        std::vector<int> m_order;   // engine indices by resolution, largest first
+    };
+}
+
+#endif // RTDETR_ROUTER_H_
@@ -0,0 +1,155 @@
+#ifndef RTDETR_SCHEDULER_H_
+#define RTDETR_SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+namespace seeta {
+
+    // "0,1,3" -> {0, 1, 3}, empty means the current device only
+    static std::vector<int> parse_devices(const std::string& devices) {
+        std::vector<int> result;
+        std::stringstream items(devices);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            if (item.find_first_of("0123456789") != std::string::npos) result.push_back(atoi(item.c_str()));
+        }
+        return result;
+    }
+
+    // device of each of instances, spread round robin over devices. -1 (current device) if devices is empty
+    static std::vector<int> instance_devices(const std::vector<int>& devices, int instances) {
+        std::vector<int> result(instances, -1);
+        for (int i = 0; i < instances && !devices.empty(); ++i) result[i] = devices[i % devices.size()];
+        return result;
+    }
+
+    // routes jobs to detector instances spread over devices. jobs running together on a device share
+    // it, so a job goes to a free instance of the device expected to finish it first: (running jobs + 1)
+    // x the recent service time of the device (job latency / jobs running with it). a slower or busier
+    // device gets proportionally less work. an instance runs one job at a time.
+    // no cuda in here, the routing is the same for real instances and simulated ones
+    class DeviceScheduler {
+        public:
+        struct DeviceStats {
+            int device;
+            int instances;
+            int64_t jobs;
+            int64_t busy_us;        // summed job latency
+            double service_us;      // recent job latency per job running on the device, moving average
+        };
+
+        // instance i runs on devices[i]
+        explicit DeviceScheduler(const std::vector<int>& devices) : m_start(std::chrono::steady_clock::now()) {
+            m_instance_slot.resize(devices.size());
+            m_instance_running.resize(devices.size());
+            for (size_t i = 0; i < devices.size(); ++i) {
+                size_t slot = 0;
+                while (slot < m_devices.size() && m_devices[slot].stats.device != devices[i]) slot++;
+                if (slot == m_devices.size()) {
+                    m_devices.push_back(Device());
+                    m_devices.back().stats.device = devices[i];
+                }
+                m_devices[slot].stats.instances++;
+                m_devices[slot].free.push_back(int(i));
+                m_instance_slot[i] = int(slot);
+            }
+        }
+
+        // a free instance of the device expected to finish first, blocks until an instance is free
+        int acquire() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            int best = -1;
+            m_cond.wait(lock, [this, &best] {
+                best = pick();
+                return best >= 0;
+            });
+            Device& device = m_devices[best];
+            int instance = device.free.back();
+            device.free.pop_back();
+            device.running++;
+            m_instance_running[instance] = device.running;
+            return instance;
+        }
+
+        // instance finished its job, latency_us from acquire to release
+        void release(int instance, int64_t latency_us) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                Device& device = m_devices[m_instance_slot[instance]];
+                // jobs sharing the device while this one ran, about
+                double sharing = (m_instance_running[instance] + device.running) / 2.0;
+                double service_us = latency_us / sharing;
+                device.running--;
+                device.free.push_back(instance);
+                device.stats.jobs++;
+                device.stats.busy_us += latency_us;
+                // first jobs include warm up, a short average forgets them quickly
+                device.stats.service_us = device.stats.service_us > 0.0
+                    ? device.stats.service_us * (1.0 - kServiceWeight) + service_us * kServiceWeight
+                    : service_us;
+            }
+            m_cond.notify_one();
+        }
+
+        std::vector<DeviceStats> stats() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<DeviceStats> result;
+            for (const Device& device : m_devices) result.push_back(device.stats);
+            return result;
+        }
+
+        // jobs per device since construction
+        std::string report() {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+            std::ostringstream out;
+            for (const DeviceStats& stats : this->stats()) {
+                out << "Device " << stats.device << " (" << stats.instances << " instances): " << stats.jobs
+                    << " jobs, " << (seconds > 0.0 ? stats.jobs / seconds : 0.0) << " fps, mean latency "
+                    << (stats.jobs > 0 ? stats.busy_us / 1000.0 / stats.jobs : 0.0) << "ms" << std::endl;
+            }
+            return out.str();
+        }
+
+        private:
+        static constexpr double kServiceWeight = 0.1;
+
+        struct Device {
+            DeviceStats stats = {0, 0, 0, 0, 0.0};
+            int running = 0;
+            std::vector<int> free;
+        };
+
+        // device with a free instance and the earliest expected finish, -1 if none is free.
+        // devices without jobs yet go first so every device gets a latency
+        int pick() const {
+            int best = -1;
+            double best_cost = 0.0;
+            for (size_t i = 0; i < m_devices.size(); ++i) {
+                const Device& device = m_devices[i];
+                if (device.free.empty()) continue;
+                double cost = (device.running + 1) * device.stats.service_us;
+                if (best < 0 || cost < best_cost) {
+                    best = int(i);
+                    best_cost = cost;
+                }
+            }
+            return best;
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::vector<Device> m_devices;
+        std::vector<int> m_instance_slot;
+        std::vector<int> m_instance_running;    // jobs running on the device when the instance was acquired
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
+
+#endif // RTDETR_SCHEDULER_H_
@@ -0,0 +1,226 @@
+#ifndef RTDETR_SHM_RING_H_
+#define RTDETR_SHM_RING_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <climits>
+#include <cstddef>
+#include <new>
+#include <atomic>
+#include <string>
+#include <iostream>
+
+namespace seeta {
+
+    // single producer, single consumer ring of fixed size slots in posix shared memory.
+    // frames go from a capture process to the detector in one ring and the detections come
+    // back in another, both sides work on the slots in place.
+    //
+    // write_seq and read_seq only grow, slot i holds sequence i % slot_count. the waiting side
+    // sleeps on a futex word in the shared header, the other side bumps and wakes it.
+
+    static const uint32_t kShmRingMagic = 0x474E5252;   // "RRNG"
+    static const uint32_t kShmRingVersion = 1;
+
+    struct shm_ring_header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t reserved;
+        uint64_t slot_bytes;                // payload bytes of a slot
+        uint64_t slot_stride;               // ring_slot header and payload, cache line aligned
+        alignas(64) std::atomic<uint64_t> write_seq;
+        std::atomic<uint32_t> written;      // futex word, bumped on every write
+        alignas(64) std::atomic<uint64_t> read_seq;
+        std::atomic<uint32_t> read;         // futex word, bumped on every release
+        alignas(64) std::atomic<uint32_t> closed;
+    };
+
+    // what the writer tells the reader about a slot payload
+    struct ring_slot {
+        uint64_t sequence;
+        uint64_t frame_id;
+        int64_t timestamp_us;               // CLOCK_MONOTONIC, comparable between processes
+        int32_t width;
+        int32_t height;
+        int32_t channels;
+        uint32_t count;                     // detections of a result slot
+        alignas(64) unsigned char data[1];  // slot_bytes
+    };
+
+    static int64_t monotonic_us() {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return int64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+    }
+
+    class ShmRing {
+        public:
+        // creates (or replaces) the named ring, it is unlinked when the owner is destroyed
+        static ShmRing* create(const std::string& name, int slot_count, size_t slot_bytes) {
+            size_t stride = (offsetof(ring_slot, data) + slot_bytes + 63) / 64 * 64;
+            size_t size = sizeof(shm_ring_header) + stride * slot_count;
+            shm_unlink(name.c_str());
+            int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0 || ftruncate(fd, size) != 0) {
+                std::cerr << "create shared memory " << name << " failed: " << strerror(errno) << std::endl;
+                if (fd >= 0) close(fd);
+                return nullptr;
+            }
+            void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (memory == MAP_FAILED) {
+                std::cerr << "map shared memory " << name << " failed: " << strerror(errno) << std::endl;
+                shm_unlink(name.c_str());
+                return nullptr;
+            }
+            shm_ring_header* header = new (memory) shm_ring_header();
+            header->slot_count = slot_count;
+            header->slot_bytes = slot_bytes;
+            header->slot_stride = stride;
+            header->write_seq = 0;
+            header->written = 0;
+            header->read_seq = 0;
+            header->read = 0;
+            header->closed = 0;
+            header->version = kShmRingVersion;
+            // attachers check the magic last
+            std::atomic_thread_fence(std::memory_order_release);
+            header->magic = kShmRingMagic;
+            return new ShmRing(name, memory, size, true);
+        }
+
+        // attaches to a ring created by another process, nullptr if it does not exist (yet)
+        static ShmRing* open(const std::string& name) {
+            int fd = shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd < 0) return nullptr;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(shm_ring_header)) {
+                close(fd);
+                return nullptr;
+            }
+            void* memory = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (memory == MAP_FAILED) return nullptr;
+            shm_ring_header* header = (shm_ring_header*)memory;
+            if (header->magic != kShmRingMagic || header->version != kShmRingVersion ||
+                sizeof(shm_ring_header) + header->slot_stride * header->slot_count > size_t(st.st_size)) {
+                std::cerr << "shared memory " << name << " is not a ring of this version." << std::endl;
+                munmap(memory, st.st_size);
+                return nullptr;
+            }
+            return new ShmRing(name, memory, st.st_size, false);
+        }
+
+        ~ShmRing() {
+            munmap(m_memory, m_size);
+            if (m_owner) shm_unlink(m_name.c_str());
+        }
+
+        // slot to fill, nullptr if the ring stays full for timeout_ms (0 does not wait, < 0 waits forever)
+        ring_slot* begin_write(int timeout_ms) {
+            uint64_t sequence = m_header->write_seq.load(std::memory_order_relaxed);
+            if (!wait_for(m_header->read, timeout_ms, [&] {
+                    return sequence - m_header->read_seq.load(std::memory_order_acquire) < m_header->slot_count;
+                })) {
+                return nullptr;
+            }
+            ring_slot* slot = slot_at(sequence);
+            slot->sequence = sequence;
+            return slot;
+        }
+
+        // publishes the slot of begin_write
+        void end_write() {
+            m_header->write_seq.fetch_add(1, std::memory_order_release);
+            wake(m_header->written);
+        }
+
+        // oldest unread slot, nullptr on timeout or if the ring is closed and drained
+        ring_slot* begin_read(int timeout_ms) {
+            uint64_t sequence = m_header->read_seq.load(std::memory_order_relaxed);
+            if (!wait_for(m_header->written, timeout_ms, [&] {
+                    return m_header->write_seq.load(std::memory_order_acquire) > sequence;
+                })) {
+                return nullptr;
+            }
+            return slot_at(sequence);
+        }
+
+        // hands the slot of begin_read back to the writer
+        void end_read() {
+            m_header->read_seq.fetch_add(1, std::memory_order_release);
+            wake(m_header->read);
+        }
+
+        // no more writes, waiting readers return once the ring is drained
+        void close_writer() {
+            m_header->closed.store(1, std::memory_order_release);
+            wake(m_header->written);
+            wake(m_header->read);
+        }
+
+        bool closed() const {
+            return m_header->closed.load(std::memory_order_acquire) != 0;
+        }
+
+        size_t slot_bytes() const { return m_header->slot_bytes; }
+        int slot_count() const { return m_header->slot_count; }
+        // unread slots
+        int pending() const {
+            return int(m_header->write_seq.load(std::memory_order_acquire) - m_header->read_seq.load(std::memory_order_acquire));
+        }
+
+        private:
+        ShmRing(const std::string& name, void* memory, size_t size, bool owner)
+            : m_name(name), m_memory(memory), m_size(size), m_owner(owner), m_header((shm_ring_header*)memory) {}
+
+        ring_slot* slot_at(uint64_t sequence) const {
+            return (ring_slot*)((char*)m_memory + sizeof(shm_ring_header) +
+                                (sequence % m_header->slot_count) * m_header->slot_stride);
+        }
+
+        // sleeps on the futex word until ready(), a closed ring or the timeout
+        template <typename Ready>
+        bool wait_for(std::atomic<uint32_t>& word, int timeout_ms, Ready ready) {
+            int64_t deadline = timeout_ms < 0 ? -1 : monotonic_us() + int64_t(timeout_ms) * 1000;
+            while (true) {
+                // read the word before the condition, a wake in between changes it and the futex returns
+                uint32_t value = word.load(std::memory_order_acquire);
+                if (ready()) return true;
+                if (closed()) return ready();
+                timespec timeout;
+                timespec* timeout_ptr = nullptr;
+                if (deadline >= 0) {
+                    int64_t remain = deadline - monotonic_us();
+                    if (remain <= 0) return false;
+                    timeout.tv_sec = remain / 1000000;
+                    timeout.tv_nsec = (remain % 1000000) * 1000;
+                    timeout_ptr = &timeout;
+                }
+                syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAIT, value, timeout_ptr, nullptr, 0);
+            }
+        }
+
+        static void wake(std::atomic<uint32_t>& word) {
+            word.fetch_add(1, std::memory_order_release);
+            syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        std::string m_name;
+        void* m_memory;
+        size_t m_size;
+        bool m_owner;
+        shm_ring_header* m_header;
+    };
+}
+
+#endif // RTDETR_SHM_RING_H_
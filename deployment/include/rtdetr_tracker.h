@@ -0,0 +1,239 @@
+#ifndef RTDETR_TRACKER_H_
+#define RTDETR_TRACKER_H_
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "rtdetr.h"
+#include "rtdetr_nms.h"
+
+namespace seeta {
+
+    // constant velocity kalman filter of one box coordinate, state is [position, velocity]
+    class KalmanAxis {
+        public:
+        void init(float position, float process_noise, float measure_noise) {
+            m_position = position;
+            m_velocity = 0.0f;
+            // unknown velocity at start
+            m_p00 = measure_noise;
+            m_p01 = 0.0f;
+            m_p11 = 10.0f * measure_noise;
+            m_q = process_noise;
+            m_r = measure_noise;
+        }
+
+        void predict() {
+            m_position += m_velocity;
+            // P = F * P * F' + Q, F = [1 1; 0 1]
+            m_p00 += 2 * m_p01 + m_p11 + m_q;
+            m_p01 += m_p11;
+            m_p11 += m_q;
+        }
+
+        void update(float measurement) {
+            float residual = measurement - m_position;
+            float s = m_p00 + m_r;
+            float k0 = m_p00 / s;
+            float k1 = m_p01 / s;
+            m_position += k0 * residual;
+            m_velocity += k1 * residual;
+            // P = (I - K * H) * P, H = [1 0]
+            m_p11 -= k1 * m_p01;
+            m_p01 -= k0 * m_p01;
+            m_p00 -= k0 * m_p00;
+        }
+
+        float position() const { return m_position; }
+
+        private:
+        float m_position;
+        float m_velocity;
+        float m_p00, m_p01, m_p11;
+        float m_q;
+        float m_r;
+    };
+
+    struct tracker_config {
+        float match_iou = 0.3f;         // detection and predicted track with iou above are the same object
+        float match_distance = 1.0f;    // or centers closer than match_distance box sizes per missed frame,
+                                        // small fast objects do not overlap their first prediction
+        int max_misses = 6;             // tracks not detected for more frames are removed
+        float confidence_decay = 0.9f;  // track confidence is multiplied on every predicted frame
+        float process_noise = 1.0f;
+        float measure_noise = 4.0f;
+    };
+
+    // light weight iou tracker with kalman filtered boxes, it carries detections forward
+    // on frames skipped by the detector and assigns track ids.
+    class IouTracker {
+        public:
+        explicit IouTracker(const tracker_config& config = tracker_config()) : m_config(config) {}
+
+        // a detected frame: predict tracks, match them with detections and correct them.
+        // returns the detections with track ids.
+        const std::vector<detect_result>& update(const detect_result* detections, int size) {
+            for (Track& track : m_tracks) predict(track);
+
+            // greedy matching, best iou first, then the closest centers
+            std::vector<MatchPair> pairs;
+            for (int d = 0; d < size; ++d) {
+                for (int t = 0; t < (int)m_tracks.size(); ++t) {
+                    if (m_tracks[t].cls != detections[d].cls) continue;
+                    bbox box = m_tracks[t].box();
+                    float iou = box_iou(box, detections[d].box);
+                    if (iou >= m_config.match_iou) {
+                        pairs.push_back({iou, d, t});
+                        continue;
+                    }
+                    float dx = (box.x + box.width / 2) - (detections[d].box.x + detections[d].box.width / 2);
+                    float dy = (box.y + box.height / 2) - (detections[d].box.y + detections[d].box.height / 2);
+                    float limit = m_config.match_distance * std::max(box.width, box.height) * (m_tracks[t].misses + 1);
+                    float distance = std::sqrt(dx * dx + dy * dy);
+                    if (limit > 0 && distance <= limit) pairs.push_back({-distance / limit, d, t});
+                }
+            }
+            std::sort(pairs.begin(), pairs.end(), [](const MatchPair& a, const MatchPair& b) {
+                return a.priority > b.priority;
+            });
+
+            std::vector<int> detection_track(size, -1);
+            std::vector<bool> track_matched(m_tracks.size(), false);
+            for (const MatchPair& pair : pairs) {
+                if (detection_track[pair.detection] >= 0 || track_matched[pair.track]) continue;
+                detection_track[pair.detection] = pair.track;
+                track_matched[pair.track] = true;
+            }
+
+            m_results.clear();
+            for (int d = 0; d < size; ++d) {
+                int t = detection_track[d];
+                if (t >= 0) {
+                    correct(m_tracks[t], detections[d]);
+                } else {
+                    m_tracks.push_back(create(detections[d]));
+                    t = m_tracks.size() - 1;
+                }
+                detect_result result = detections[d];
+                result.track_id = m_tracks[t].id;
+                m_results.push_back(result);
+            }
+
+            // unmatched tracks are kept for a while, the detector may miss them on one frame
+            for (size_t t = 0; t < track_matched.size(); ++t) {
+                if (!track_matched[t]) m_tracks[t].misses++;
+            }
+            remove_lost();
+            return m_results;
+        }
+
+        // a skipped frame: move all tracks forward, returns the predicted boxes
+        const std::vector<detect_result>& predict() {
+            m_results.clear();
+            for (Track& track : m_tracks) {
+                predict(track);
+                track.misses++;
+                track.confidence *= m_config.confidence_decay;
+            }
+            remove_lost();
+            for (const Track& track : m_tracks) {
+                detect_result result;
+                result.box = track.box();
+                result.score = track.confidence;
+                result.cls = track.cls;
+                result.track_id = track.id;
+                if (result.box.width > 0 && result.box.height > 0) m_results.push_back(result);
+            }
+            return m_results;
+        }
+
+        // lowest track confidence, 1 if nothing is tracked
+        float confidence() const {
+            float confidence = 1.0f;
+            for (const Track& track : m_tracks) confidence = std::min(confidence, track.confidence);
+            return confidence;
+        }
+
+        int tracks_num() const {
+            return m_tracks.size();
+        }
+
+        void reset() {
+            m_tracks.clear();
+            m_results.clear();
+        }
+
+        private:
+        struct Track {
+            int id;
+            int cls;
+            float confidence;
+            int misses;
+            // center x, center y, width, height
+            KalmanAxis axes[4];
+
+            bbox box() const {
+                bbox box;
+                box.width = axes[2].position();
+                box.height = axes[3].position();
+                box.x = axes[0].position() - box.width / 2;
+                box.y = axes[1].position() - box.height / 2;
+                return box;
+            }
+        };
+
+        struct MatchPair {
+            float priority; // iou, or negative normalized center distance
+            int detection;
+            int track;
+        };
+
+        Track create(const detect_result& detection) {
+            Track track;
+            track.id = m_next_id++;
+            track.cls = detection.cls;
+            track.confidence = detection.score;
+            track.misses = 0;
+            float measures[4];
+            measurement(detection.box, measures);
+            for (int i = 0; i < 4; ++i) {
+                track.axes[i].init(measures[i], m_config.process_noise, m_config.measure_noise);
+            }
+            return track;
+        }
+
+        void predict(Track& track) {
+            for (int i = 0; i < 4; ++i) track.axes[i].predict();
+        }
+
+        void correct(Track& track, const detect_result& detection) {
+            float measures[4];
+            measurement(detection.box, measures);
+            for (int i = 0; i < 4; ++i) track.axes[i].update(measures[i]);
+            track.confidence = detection.score;
+            track.misses = 0;
+        }
+
+        static void measurement(const bbox& box, float* measures) {
+            measures[0] = box.x + box.width / 2;
+            measures[1] = box.y + box.height / 2;
+            measures[2] = box.width;
+            measures[3] = box.height;
+        }
+
+        void remove_lost() {
+            int max_misses = m_config.max_misses;
+            m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(), [max_misses](const Track& track) {
+                return track.misses > max_misses;
+            }), m_tracks.end());
+        }
+
+        tracker_config m_config;
+        std::vector<Track> m_tracks;
+        std::vector<detect_result> m_results;
+        int m_next_id = 1;
+    };
+}
+
+#endif // RTDETR_TRACKER_H_
@@ -1,16 +1,27 @@
+#ifndef RTDETR_UTILS_H_
+#define RTDETR_UTILS_H_
+
 #include <dirent.h>
 #include <cstring>
+#include <cstdlib>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cmath>
 #include <memory>
 #include <queue>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/imgproc.hpp"
 
+#include "rtdetr.h"
+#include "rtdetr_nms.h"
+#include "rtdetr_half.h"
+#include "rtdetr_kernels.h"
+
 namespace seeta {
 	static const std::string FileSeparator() {
 #if ORZ_PLATFORM_OS_WINDOWS
@@ -133,13 +144,24 @@ static std::string getBaseName(const std::string& filename) {
         }
     }
 
-    // letter box
-    static cv::Mat letter_box(const cv::Mat &origin_mat,int model_input_width, 
+    // 读取整个文件, 编码后的图片可以先做哈希再解码
+    static bool read_file(const std::string& path, std::vector<unsigned char>& bytes) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) {
+            std::cerr << "open " << path << " failed." << std::endl;
+            return false;
+        }
+        std::streamsize size = in.tellg();
+        in.seekg(0, std::ios::beg);
+        bytes.resize(size);
+        return size == 0 || bool(in.read((char*)bytes.data(), size));
+    }
+
+    // scale and padding of the letter box
+    static void letter_box_params(int image_width, int image_height, int model_input_width, 
                         int model_input_height, float& scale_x, float& scale_y, int& padding_top, int& padding_bottom, 
                         int& padding_left, int& padding_right, bool scale_fill)
-    {   
-        int image_width = origin_mat.cols;
-        int image_height = origin_mat.rows;
+    {
         if (scale_fill) {
             // just stretch
 
@@ -164,7 +186,17 @@ static std::string getBaseName(const std::string& filename) {
             padding_left = int(std::round(dw - 0.1));
             padding_right = int(std::round(dw + 0.1));
         }
-        
+    }
+
+    // letter box
+    static cv::Mat letter_box(const cv::Mat &origin_mat,int model_input_width, 
+                        int model_input_height, float& scale_x, float& scale_y, int& padding_top, int& padding_bottom, 
+                        int& padding_left, int& padding_right, bool scale_fill)
+    {   
+        int image_width = origin_mat.cols;
+        int image_height = origin_mat.rows;
+        letter_box_params(image_width, image_height, model_input_width, model_input_height,
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, scale_fill);
 
          // resize image
         cv::Mat resized_mat;
@@ -177,6 +209,7 @@ static std::string getBaseName(const std::string& filename) {
         return padded_image;
     }
 
+    // origin_mat is bgr or gray, chw_data gets 3 rgb planes normalized to [0, 1]
     static bool preprocess(const cv::Mat& origin_mat, int model_input_width, int model_input_height,
                                 float& scale_x, float&scale_y, int&padding_top, int&padding_bottom,
                                 int& padding_left, int& padding_right, bool scale_fill, float* chw_data) 
@@ -185,6 +218,17 @@ static std::string getBaseName(const std::string& filename) {
         cv::Mat resized_border_mat = letter_box(origin_mat, model_input_width, model_input_height,
                                         scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, scale_fill);
 
+        // gray input: normalize one plane and copy it into the three planes,
+        // no channel expansion, color conversion or split of three times the data
+        if (resized_border_mat.channels() == 1) {
+            int plane_size = resized_border_mat.rows * resized_border_mat.cols;
+            cv::Mat plane(resized_border_mat.rows, resized_border_mat.cols, CV_32FC1, chw_data);
+            resized_border_mat.convertTo(plane, CV_32FC1, 1.0 / 255);
+            memcpy(chw_data + plane_size, chw_data, plane_size * sizeof(float));
+            memcpy(chw_data + 2 * plane_size, chw_data, plane_size * sizeof(float));
+            return true;
+        }
+
         // bgr to rgb
         cv::Mat rgb_mat;
         cv::cvtColor(resized_border_mat, rgb_mat, cv::COLOR_BGR2RGB);
@@ -221,4 +265,337 @@ static std::string getBaseName(const std::string& filename) {
 
         return true;
     }
-}
\ No newline at end of file
+    // engines with a fp16 input binding: bgr to rgb, /255 and chw written as half directly,
+    // without the float image and split of preprocess
+    static bool preprocess_half(const cv::Mat& origin_mat, int model_input_width, int model_input_height,
+                                float& scale_x, float&scale_y, int&padding_top, int&padding_bottom,
+                                int& padding_left, int& padding_right, bool scale_fill, uint16_t* chw_data)
+    {
+        cv::Mat resized_border_mat = letter_box(origin_mat, model_input_width, model_input_height,
+                                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, scale_fill);
+        int plane_size = resized_border_mat.rows * resized_border_mat.cols;
+        const float scale = 1.0f / 255;
+        if (resized_border_mat.channels() == 1) {
+            if (!resized_border_mat.isContinuous()) resized_border_mat = resized_border_mat.clone();
+            uint8_to_half(resized_border_mat.data, chw_data, plane_size, scale);
+            memcpy(chw_data + plane_size, chw_data, plane_size * sizeof(uint16_t));
+            memcpy(chw_data + 2 * plane_size, chw_data, plane_size * sizeof(uint16_t));
+            return true;
+        }
+
+        std::vector<cv::Mat> bgr;
+        cv::split(resized_border_mat, bgr);
+        for (int c = 0; c < 3; ++c) {
+            // bgr to rgb
+            uint8_to_half(bgr[2 - c].data, chw_data + c * plane_size, plane_size, scale);
+        }
+        return true;
+    }
+
+    // letterbox only, hwc_data gets model_input_width x model_input_height uint8 pixels with the
+    // channels of origin_mat. normalization and chw happen on the device, see rtdetr_kernels.h
+    static bool preprocess_uint8(const cv::Mat& origin_mat, int model_input_width, int model_input_height,
+                                float& scale_x, float&scale_y, int&padding_top, int&padding_bottom,
+                                int& padding_left, int& padding_right, bool scale_fill, unsigned char* hwc_data)
+    {
+        cv::Mat resized_border_mat = letter_box(origin_mat, model_input_width, model_input_height,
+                                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, scale_fill);
+        cv::Mat hwc(model_input_height, model_input_width, resized_border_mat.type(), hwc_data);
+        resized_border_mat.copyTo(hwc);
+        return true;
+    }
+
+    // the letter box of origin_mat as done by letter_box, for letterbox_cpu and letterbox_gpu
+    static letterbox_geometry make_letterbox_geometry(const cv::Mat& origin_mat, int model_input_width,
+                                int model_input_height, float& scale_x, float&scale_y, int&padding_top,
+                                int&padding_bottom, int& padding_left, int& padding_right, bool scale_fill)
+    {
+        letter_box_params(origin_mat.cols, origin_mat.rows, model_input_width, model_input_height,
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, scale_fill);
+        letterbox_geometry geometry;
+        geometry.src_width = origin_mat.cols;
+        geometry.src_height = origin_mat.rows;
+        geometry.channels = origin_mat.channels();
+        geometry.dst_width = model_input_width;
+        geometry.dst_height = model_input_height;
+        // the resize size of letter_box, the padding fills the rest
+        geometry.resized_width = std::min(int(origin_mat.cols * scale_x), model_input_width - padding_left);
+        geometry.resized_height = std::min(int(origin_mat.rows * scale_y), model_input_height - padding_top);
+        geometry.pad_left = padding_left;
+        geometry.pad_top = padding_top;
+        return geometry;
+    }
+
+    static std::vector<float> cxcywh_to_xyxy(const std::vector<float>& box) {
+        float x1 = box[0] - box[2] / 2.0f;
+        float y1 = box[1] - box[3] / 2.0;
+        float x2 = box[0] + box[2] / 2.0f;
+        float y2 = box[1] + box[3] / 2.0f;
+        std::vector<float> results = {x1, y1, x2, y2};
+        return results;
+    }
+
+    // result of a query above the threshold, box decoded as cxcywh_to_xyxy does and clipped to the image.
+    // boxes clipped to nothing are dropped
+    static inline void push_query_result(const float* output, float max_score, int max_idx, int origin_image_width,
+                int origin_image_height, std::vector<detect_result>& results)
+    {
+        float cx = output[0];
+        float cy = output[1];
+        float width = output[2];
+        float height = output[3];
+        float x1 = cx - width / 2.0f;
+        float y1 = cy - height / 2.0;
+        float x2 = cx + width / 2.0f;
+        float y2 = cy + height / 2.0f;
+        // decode location
+        x1 = std::min(std::max(0.0f, x1 * origin_image_width), origin_image_width - 1.0f);
+        y1 = std::min(std::max(0.0f, y1 * origin_image_height), origin_image_height - 1.0f);
+        x2 = std::min(std::max(0.0f, x2 * origin_image_width), origin_image_width - 1.0f);
+        y2 = std::min(std::max(0.0f, y2 * origin_image_height), origin_image_height - 1.0f);
+        detect_result result;
+        result.score = max_score;
+        result.cls = max_idx;
+        result.track_id = -1;
+        result.box.x = x1;
+        result.box.y = y1;
+        result.box.width = x2 - x1;
+        result.box.height = y2 - y1;
+        if ((result.box.width > 0) && (result.box.height > 0)) {
+            results.emplace_back(result);
+        }
+    }
+
+    // post processing for any class count
+    // raw_output num_queries x (4 + cls_num)
+    static void postprocess_generic(const float* raw_output, int num_queries, int cls_num, int origin_image_width, 
+                int origin_image_height, float conf_thresh, std::vector<detect_result>& results) 
+    {
+        for (int i = 0; i < num_queries; ++i) {
+            const float* output = raw_output + i * (4 + cls_num);
+            const float* scores = output + 4;
+            int max_idx = 0;
+            float max_score = 0.0f;
+
+            for (int j = 0; j < cls_num; j++) {
+                if (scores[j] > max_score) {
+                    max_score = scores[j];
+                    max_idx = j;
+                }
+            }
+
+            // only collect result which confidence is greater than thresh
+            if (max_score >= conf_thresh) {
+                push_query_result(output, max_score, max_idx, origin_image_width, origin_image_height, results);
+            }
+        }
+    }
+
+    // post processing for a class count known at compile time. the max score is a branchless
+    // reduction over kLanes independent maxima, fully unrolled and vectorized by the compiler;
+    // the class of the max is only searched for the few queries above the threshold.
+    // same results as postprocess_generic
+    template <int kClsNum, int kLanes = (kClsNum < 8 ? kClsNum : 8)>
+    static void postprocess_fixed(const float* raw_output, int num_queries, int origin_image_width, 
+                int origin_image_height, float conf_thresh, std::vector<detect_result>& results) 
+    {
+        for (int i = 0; i < num_queries; ++i) {
+            const float* output = raw_output + i * (4 + kClsNum);
+            const float* scores = output + 4;
+            float lanes[kLanes] = {};
+            for (int j = 0; j + kLanes <= kClsNum; j += kLanes) {
+                for (int k = 0; k < kLanes; k++) {
+                    lanes[k] = scores[j + k] > lanes[k] ? scores[j + k] : lanes[k];
+                }
+            }
+            float max_score = 0.0f;
+            for (int j = kClsNum - kClsNum % kLanes; j < kClsNum; j++) {
+                max_score = scores[j] > max_score ? scores[j] : max_score;
+            }
+            for (int k = 0; k < kLanes; k++) {
+                max_score = lanes[k] > max_score ? lanes[k] : max_score;
+            }
+            if (max_score < conf_thresh) continue;
+
+            // first class of the max, class 0 if no score is above 0 like the generic loop
+            int max_idx = 0;
+            if (max_score > 0.0f) {
+                while (scores[max_idx] != max_score) max_idx++;
+            }
+            push_query_result(output, max_score, max_idx, origin_image_width, origin_image_height, results);
+        }
+    }
+
+    // post processing to get results, specialized for 1 (drone) and 80 (coco) classes
+    // raw_output num_queries x (4 + cls_num)
+    static void postprocess(const float* raw_output, int num_queries, int cls_num, int origin_image_width, 
+                int origin_image_height, float conf_thresh, std::vector<detect_result>& results) 
+    {
+        switch (cls_num) {
+            case 1:
+                postprocess_fixed<1>(raw_output, num_queries, origin_image_width, origin_image_height,
+                                    conf_thresh, results);
+                break;
+            case 80:
+                postprocess_fixed<80>(raw_output, num_queries, origin_image_width, origin_image_height,
+                                    conf_thresh, results);
+                break;
+            default:
+                postprocess_generic(raw_output, num_queries, cls_num, origin_image_width, origin_image_height,
+                                    conf_thresh, results);
+        }
+    }
+
+    // tiles advance tile_size - overlap pixels, other overlaps are a configuration error
+    static bool valid_tile_overlap(int tile_size, int overlap) {
+        return overlap >= 0 && overlap < tile_size;
+    }
+
+    // split [0, length) into tile_size windows, the last window is aligned to the end.
+    // overlap is checked by valid_tile_overlap
+    static std::vector<int> tile_offsets(int length, int tile_size, int overlap) {
+        std::vector<int> offsets;
+        if (length <= tile_size) {
+            offsets.push_back(0);
+            return offsets;
+        }
+        int step = tile_size - overlap;
+        for (int offset = 0; offset + tile_size < length; offset += step) {
+            offsets.push_back(offset);
+        }
+        offsets.push_back(length - tile_size);
+        return offsets;
+    }
+
+    // overlapped tiles covering the whole image, tiles are clipped for small images
+    static std::vector<cv::Rect> make_tiles(int image_width, int image_height, int tile_size, int overlap) {
+        std::vector<cv::Rect> tiles;
+        std::vector<int> xs = tile_offsets(image_width, tile_size, overlap);
+        std::vector<int> ys = tile_offsets(image_height, tile_size, overlap);
+        for (int y : ys) {
+            for (int x : xs) {
+                tiles.push_back(cv::Rect(x, y, std::min(tile_size, image_width - x), 
+                                std::min(tile_size, image_height - y)));
+            }
+        }
+        return tiles;
+    }
+
+    // merge duplicated boxes of neighbour tiles and the full frame, keep the highest score with the
+    // extent of the largest duplicate. boxes cut by a tile seam are mostly inside the whole one, so
+    // overlap is measured on the smaller box, and a cut box that scores higher must not lose the extent
+    static void merge_tile_results(std::vector<detect_result>& results, float merge_thresh) {
+        nms(results, merge_thresh, false, 0, NMS_IOS, true);
+    }
+
+    // write results to txt, one line per box:
+    // index cls score x1 y1 x2 y1 x2 y2 x1 y2 cx cy
+    // with_track_id appends the track id as the last column
+    static bool write_results(const std::string& saved_txt, const detect_result* results, int size,
+                            bool with_track_id = false) {
+        std::ofstream out(saved_txt);
+        if (!out.is_open()) {
+            std::cerr << "open " << saved_txt << " failed." << std::endl;
+            return false;
+        }
+        for (int j = 0; j < size; ++j) {
+            float score = results[j].score;
+            bbox box = results[j].box;
+            int cls = results[j].cls;
+            if (j != 0) out << std::endl;
+            out << j + 1 << " " << cls << " " << score 
+                << " " << box.x << " " << box.y
+                << " " << box.x + box.width << " " << box.y
+                << " " << box.x + box.width << " " << box.y + box.height
+                << " " << box.x << " " << box.y + box.height
+                << " " << box.x + box.width / 2.0 << " " << box.y + box.height / 2.0;
+            if (with_track_id) out << " " << results[j].track_id;
+        }
+        out.close();
+        return true;
+    }
+
+    static bool write_results(const std::string& saved_txt, const std::vector<detect_result>& results,
+                            bool with_track_id = false) {
+        return write_results(saved_txt, results.data(), int(results.size()), with_track_id);
+    }
+
+    // read results of write_results (and predict.py), the corners are folded back into boxes.
+    // ground truth may also be given as "cls x1 y1 x2 y2" lines, the score is 1 then
+    static bool read_results(const std::string& saved_txt, std::vector<detect_result>& results) {
+        results.clear();
+        std::ifstream in(saved_txt);
+        if (!in.is_open()) {
+            std::cerr << "open " << saved_txt << " failed." << std::endl;
+            return false;
+        }
+        std::string line;
+        float values[14];
+        while (std::getline(in, line)) {
+            int columns = 0;
+            const char* p = line.c_str();
+            char* end;
+            while (columns < 14) {
+                float value = strtof(p, &end);
+                if (end == p) break;
+                values[columns++] = value;
+                p = end;
+            }
+            detect_result result;
+            result.track_id = -1;
+            if (columns >= 13) {
+                result.cls = int(values[1]);
+                result.score = values[2];
+                result.box.x = values[3];
+                result.box.y = values[4];
+                result.box.width = values[7] - values[3];
+                result.box.height = values[8] - values[4];
+                if (columns == 14) result.track_id = int(values[13]);
+            } else if (columns == 5) {
+                result.cls = int(values[0]);
+                result.score = 1.0f;
+                result.box.x = values[1];
+                result.box.y = values[2];
+                result.box.width = values[3] - values[1];
+                result.box.height = values[4] - values[2];
+            } else {
+                continue;
+            }
+            results.push_back(result);
+        }
+        return true;
+    }
+
+    // binary results: magic, box count, detect_result records. no text formatting on the
+    // writer threads and 4x smaller files than txt
+    static const char kResultsMagic[8] = {'R', 'T', 'D', 'R', 'E', 'S', '0', '1'};
+
+    static bool write_results_binary(const std::string& saved_bin, const std::vector<detect_result>& results) {
+        std::ofstream out(saved_bin, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "open " << saved_bin << " failed." << std::endl;
+            return false;
+        }
+        uint32_t size = results.size();
+        out.write(kResultsMagic, sizeof(kResultsMagic));
+        out.write((const char*)&size, sizeof(size));
+        out.write((const char*)results.data(), size * sizeof(detect_result));
+        return bool(out);
+    }
+
+    static bool read_results_binary(const std::string& saved_bin, std::vector<detect_result>& results) {
+        results.clear();
+        std::ifstream in(saved_bin, std::ios::binary);
+        char magic[sizeof(kResultsMagic)];
+        uint32_t size = 0;
+        if (!in.read(magic, sizeof(magic)) || memcmp(magic, kResultsMagic, sizeof(magic)) != 0 ||
+            !in.read((char*)&size, sizeof(size))) {
+            std::cerr << "read " << saved_bin << " failed, not a results file." << std::endl;
+            return false;
+        }
+        results.resize(size);
+        return size == 0 || bool(in.read((char*)results.data(), size * sizeof(detect_result)));
+    }
+}
+
+#endif // RTDETR_UTILS_H_
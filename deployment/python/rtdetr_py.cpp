@@ -0,0 +1,177 @@
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "rtdetr.h"
+
+// python module of seeta::Rtdetr, numpy uint8 hwc images are read in place and the gil is
+// released while the engine runs.
+//
+//   import numpy as np, cv2, rtdetr_trt
+//   model = rtdetr_trt.Rtdetr("rtdetr-l.engine", 0.5)
+//   dets = model.detect(cv2.imread("bus.jpg"))        # structured array x, y, width, height, score, cls, track_id
+//   batch = model.detect_batch([image0, image1])
+//   dets = model.detect_encoded(open("bus.jpg", "rb").read())
+
+namespace py = pybind11;
+
+// flat numpy record of detect_result
+struct py_detection {
+    float x;
+    float y;
+    float width;
+    float height;
+    float score;
+    int32_t cls;
+    int32_t track_id;
+};
+static_assert(sizeof(py_detection) == sizeof(detect_result), "py_detection must match detect_result");
+
+// the buffer of a 2d (gray) or hwc uint8 array as a cv::Mat header, no copy.
+// rows may be strided, pixels and channels must be packed.
+static cv::Mat as_mat(const py::buffer_info& info) {
+    if (info.format != py::format_descriptor<uint8_t>::format() || info.itemsize != 1) {
+        throw py::value_error("image must be a uint8 array");
+    }
+    int channels = info.ndim == 3 ? info.shape[2] : 1;
+    if ((info.ndim != 2 && info.ndim != 3) || (channels != 1 && channels != 3)) {
+        throw py::value_error("image must be HxW or HxWx3 (bgr)");
+    }
+    if ((info.ndim == 3 && info.strides[2] != 1) || info.strides[1] != channels || info.strides[0] < info.shape[1] * channels) {
+        throw py::value_error("image pixels must be contiguous, use np.ascontiguousarray");
+    }
+    return cv::Mat(info.shape[0], info.shape[1], CV_8UC(channels), info.ptr, info.strides[0]);
+}
+
+static py::array_t<py_detection> to_array(const detect_result* results, size_t size) {
+    py::array_t<py_detection> array((py::ssize_t)size);
+    if (size > 0) memcpy(array.mutable_data(), results, size * sizeof(detect_result));
+    return array;
+}
+
+// one engine context, python threads calling the same instance take turns
+class PyRtdetr {
+    public:
+    PyRtdetr(const std::string& engine_file, float confidence_thresh)
+        : m_rtdetr(new seeta::Rtdetr(engine_file.c_str(), confidence_thresh)) {}
+
+    py::array_t<py_detection> detect(py::buffer image) {
+        py::buffer_info info = image.request();
+        cv::Mat mat = as_mat(info);
+        std::vector<detect_result> results;
+        bool failed;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int64_t errors = m_rtdetr->engine_errors();
+            if (mat.isContinuous()) {
+                detect_result_group group = m_rtdetr->detect(mat.data, mat.cols, mat.rows, mat.channels(), false);
+                if (group.size > 0) results.assign(group.data, group.data + group.size);
+            } else {
+                // strided rows, e.g. a crop view, the batch path reads them through the mat step
+                results = m_rtdetr->detect_batch(std::vector<cv::Mat>(1, mat))[0];
+            }
+            failed = m_rtdetr->engine_errors() != errors;
+        }
+        if (failed) throw std::runtime_error("engine execution failed");
+        return to_array(results.data(), results.size());
+    }
+
+    // encoded file bytes, decoded into the reused buffer of the instance
+    py::array_t<py_detection> detect_encoded(py::buffer encoded, bool gray) {
+        py::buffer_info info = encoded.request();
+        if (info.itemsize != 1) throw py::value_error("encoded image must be bytes or a uint8 array");
+        std::vector<detect_result> results;
+        bool decoded, failed;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int64_t errors = m_rtdetr->engine_errors();
+            detect_result_group group = m_rtdetr->detect_encoded((const uint8_t*)info.ptr, info.size,
+                                                gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+            failed = m_rtdetr->engine_errors() != errors;
+            decoded = group.size >= 0;
+            if (decoded) results.assign(group.data, group.data + group.size);
+        }
+        if (failed) throw std::runtime_error("engine execution failed");
+        if (!decoded) throw py::value_error("image bytes do not decode");
+        return to_array(results.data(), results.size());
+    }
+
+    std::vector<py::array_t<py_detection> > detect_batch(const std::vector<py::buffer>& images) {
+        // buffer_info keeps the arrays readable while the gil is released
+        std::vector<py::buffer_info> infos;
+        std::vector<cv::Mat> mats;
+        infos.reserve(images.size());
+        for (const py::buffer& image : images) {
+            infos.push_back(image.request());
+            mats.push_back(as_mat(infos.back()));
+        }
+        std::vector<std::vector<detect_result> > results;
+        bool failed;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int64_t errors = m_rtdetr->engine_errors();
+            results = m_rtdetr->detect_batch(mats);
+            failed = m_rtdetr->engine_errors() != errors;
+        }
+        if (failed) throw std::runtime_error("engine execution failed");
+        std::vector<py::array_t<py_detection> > arrays;
+        for (const std::vector<detect_result>& result : results) {
+            arrays.push_back(to_array(result.data(), result.size()));
+        }
+        return arrays;
+    }
+
+    void set_nms(float iou_thresh, bool agnostic, int max_det) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rtdetr->set_nms(iou_thresh, agnostic, max_det);
+    }
+
+    void set_uint8_input(bool enable) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rtdetr->set_uint8_input(enable);
+    }
+
+    int batch_size() const { return m_rtdetr->batch_size(); }
+
+    // engine input as (batch, channels, height, width)
+    py::tuple input_shape() const {
+        nvinfer1::Dims dims = m_rtdetr->input_dims();
+        py::tuple shape(dims.nbDims);
+        for (int i = 0; i < dims.nbDims; ++i) shape[i] = dims.d[i];
+        return shape;
+    }
+
+    private:
+    std::unique_ptr<seeta::Rtdetr> m_rtdetr;
+    std::mutex m_mutex;
+};
+
+PYBIND11_MODULE(rtdetr_trt, m) {
+    m.doc() = "RT-DETR TensorRT inference of libRtdetr";
+    PYBIND11_NUMPY_DTYPE(py_detection, x, y, width, height, score, cls, track_id);
+
+    py::class_<PyRtdetr>(m, "Rtdetr")
+        .def(py::init<const std::string&, float>(), py::arg("engine_file"), py::arg("confidence_thresh") = 0.5f)
+        .def("detect", &PyRtdetr::detect, py::arg("image"),
+            "Detect a uint8 HxWx3 (bgr) or HxW image, read in place. Returns a structured array of "
+            "x, y, width, height, score, cls, track_id in image coordinates.")
+        .def("detect_encoded", &PyRtdetr::detect_encoded, py::arg("encoded"), py::arg("gray") = false,
+            "Detect jpeg/png/bmp file bytes. Decoding reuses a buffer of the instance, no copy of the bytes.")
+        .def("detect_batch", &PyRtdetr::detect_batch, py::arg("images"),
+            "Detect a list of images, batch_size images share an engine pass. Returns one array per image.")
+        .def("set_nms", &PyRtdetr::set_nms, py::arg("iou_thresh"), py::arg("agnostic") = false, py::arg("max_det") = 0,
+            "Suppression after postprocess, iou_thresh <= 0 disables nms, max_det <= 0 keeps all.")
+        .def("set_uint8_input", &PyRtdetr::set_uint8_input, py::arg("enable"),
+            "Upload uint8 images and normalize them on the device.")
+        .def_property_readonly("batch_size", &PyRtdetr::batch_size)
+        .def_property_readonly("input_shape", &PyRtdetr::input_shape);
+}
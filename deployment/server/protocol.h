@@ -0,0 +1,85 @@
+#ifndef OTL_SERVER_PROTOCOL_H_
+#define OTL_SERVER_PROTOCOL_H_
+
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+#include <vector>
+
+#include "rtdetr.h"
+
+// binary protocol of rtdetr_server over a unix domain socket, host byte order.
+// a connection sends requests one after another and reads one response per request:
+//   request:  request_header, payload_size bytes
+//   response: response_header, count x detect_result (or count bytes of json for REQUEST_STATS)
+// the server closes the connection on a bad magic, an unknown type or a payload it does not expect
+namespace otl {
+
+    static const uint32_t kRequestMagic = 0x51445452;   // "RTDQ"
+    static const uint32_t kResponseMagic = 0x52445452;  // "RTDR"
+
+    enum request_type {
+        REQUEST_ENCODED = 0,    // jpg/png/bmp file bytes
+        REQUEST_RAW = 1,        // hwc uint8 frame of width x height x channels
+        REQUEST_STATS = 2,      // latency, batch size and resolution distributions as json, no payload
+    };
+
+    struct request_header {
+        uint32_t magic;
+        uint32_t type;
+        uint64_t request_id;
+        int32_t width;          // raw frames only
+        int32_t height;
+        int32_t channels;
+        uint32_t payload_size;
+        int32_t resolution;     // input size of the engine to use, the closest one. 0 lets the router choose by load
+        uint32_t reserved;
+    };
+
+    struct response_header {
+        uint32_t magic;
+        int32_t status;         // 0 ok, < 0 the request failed
+        uint64_t request_id;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    // blocking full reads and writes, false on error or closed connection
+    static bool read_full(int fd, void* data, size_t size) {
+        char* p = (char*)data;
+        while (size > 0) {
+            ssize_t n = ::read(fd, p, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool write_full(int fd, const void* data, size_t size) {
+        const char* p = (const char*)data;
+        while (size > 0) {
+            ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool make_address(const std::string& socket_path, sockaddr_un& address) {
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path)) return false;
+        strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+        return true;
+    }
+}
+
+#endif // OTL_SERVER_PROTOCOL_H_
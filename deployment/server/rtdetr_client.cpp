@@ -0,0 +1,188 @@
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "rtdetr_utils.h"
+#include "protocol.h"
+
+// closed loop load generator of rtdetr_server, every thread keeps one request in flight
+
+struct Options {
+    std::string socket_path = "/tmp/rtdetr.sock";
+    std::string images;
+    int concurrency = 4;
+    int requests = 1000;
+    bool raw = false;
+    bool stats = false;
+    int resolution = 0;
+};
+
+struct Payload {
+    std::vector<unsigned char> bytes;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+};
+
+static void usage() {
+    std::cout << "Usage: rtdetr_client --images dir [--socket /tmp/rtdetr.sock] [--concurrency 4] [--requests 1000] [--raw]\n"
+              << "                     [--resolution 640]\n"
+              << "       rtdetr_client --stats [--socket /tmp/rtdetr.sock]\n"
+              << "--raw decodes the images once and sends uint8 frames instead of the file bytes.\n"
+              << "--resolution asks for the engine of the closest input size, by default the server routes by load." << std::endl;
+}
+
+static int connect_server(const std::string& socket_path) {
+    sockaddr_un address;
+    if (!otl::make_address(socket_path, address)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_request(int fd, uint32_t type, uint64_t request_id, const Payload* payload, int resolution = 0) {
+    otl::request_header header;
+    header.magic = otl::kRequestMagic;
+    header.type = type;
+    header.request_id = request_id;
+    header.width = payload ? payload->width : 0;
+    header.height = payload ? payload->height : 0;
+    header.channels = payload ? payload->channels : 0;
+    header.payload_size = payload ? payload->bytes.size() : 0;
+    header.resolution = resolution;
+    header.reserved = 0;
+    return otl::write_full(fd, &header, sizeof(header)) &&
+            (header.payload_size == 0 || otl::write_full(fd, payload->bytes.data(), header.payload_size));
+}
+
+// reads the response, the body is detections or json
+static bool read_response(int fd, otl::response_header& header, std::vector<char>& body, size_t elem_size) {
+    if (!otl::read_full(fd, &header, sizeof(header)) || header.magic != otl::kResponseMagic) return false;
+    body.resize(header.count * elem_size);
+    return body.empty() || otl::read_full(fd, body.data(), body.size());
+}
+
+static int print_stats(const Options& options) {
+    int fd = connect_server(options.socket_path);
+    if (fd < 0) {
+        std::cerr << "connect " << options.socket_path << " failed." << std::endl;
+        return -1;
+    }
+    otl::response_header header;
+    std::vector<char> body;
+    bool ok = send_request(fd, otl::REQUEST_STATS, 0, nullptr) && read_response(fd, header, body, 1);
+    close(fd);
+    if (ok) std::cout << std::string(body.begin(), body.end()) << std::endl;
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--socket") {
+            options.socket_path = argv[++i];
+        } else if (i + 1 < argc && arg == "--images") {
+            options.images = argv[++i];
+        } else if (i + 1 < argc && arg == "--concurrency") {
+            options.concurrency = std::max(1, atoi(argv[++i]));
+        } else if (i + 1 < argc && arg == "--requests") {
+            options.requests = atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--resolution") {
+            options.resolution = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--raw") {
+            options.raw = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else {
+            usage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (options.stats) {
+        return print_stats(options);
+    }
+    if (options.images.empty()) {
+        usage();
+        return -1;
+    }
+
+    // payloads are prepared up front, the load is not limited by the client's disk or decoder
+    std::vector<Payload> payloads;
+    for (const std::string& name : seeta::FindFilesRecursively(options.images, -1)) {
+        std::string path = options.images + seeta::FileSeparator() + name;
+        Payload payload;
+        if (options.raw) {
+            cv::Mat image = cv::imread(path);
+            if (image.empty()) continue;
+            payload.width = image.cols;
+            payload.height = image.rows;
+            payload.channels = image.channels();
+            payload.bytes.assign(image.data, image.data + image.total() * image.elemSize());
+        } else if (!seeta::read_file(path, payload.bytes)) {
+            continue;
+        }
+        payloads.push_back(std::move(payload));
+    }
+    if (payloads.empty()) {
+        std::cerr << "no images in " << options.images << std::endl;
+        return -1;
+    }
+    std::cout << "Loaded " << payloads.size() << " images, " << options.concurrency << " connections, "
+            << options.requests << " requests." << std::endl;
+
+    std::atomic<int> next_request(0);
+    std::atomic<int> failed(0);
+    std::atomic<long> detections(0);
+    std::vector<std::vector<double> > latencies(options.concurrency);
+    uint32_t type = options.raw ? otl::REQUEST_RAW : otl::REQUEST_ENCODED;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.concurrency; ++t) {
+        threads.emplace_back([&, t] {
+            int fd = connect_server(options.socket_path);
+            if (fd < 0) {
+                std::cerr << "connect " << options.socket_path << " failed." << std::endl;
+                return;
+            }
+            otl::response_header header;
+            std::vector<char> body;
+            int index;
+            while ((index = next_request++) < options.requests) {
+                auto sent = std::chrono::steady_clock::now();
+                if (!send_request(fd, type, index, &payloads[index % payloads.size()], options.resolution) ||
+                    !read_response(fd, header, body, sizeof(detect_result))) {
+                    failed++;
+                    break;
+                }
+                std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - sent;
+                latencies[t].push_back(latency.count());
+                if (header.status != 0 || header.request_id != uint64_t(index)) failed++;
+                detections += header.count;
+            }
+            close(fd);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> all;
+    for (const std::vector<double>& latency : latencies) all.insert(all.end(), latency.begin(), latency.end());
+    if (all.empty()) {
+        std::cerr << "no request completed." << std::endl;
+        return -1;
+    }
+    std::sort(all.begin(), all.end());
+    std::cout << "Completed " << all.size() << " requests (" << failed << " failed) in " << duration.count() << "s, "
+            << all.size() / duration.count() << " req/s, " << detections << " detections" << std::endl;
+    std::cout << "Latency ms p50: " << all[all.size() / 2] << ", p90: " << all[all.size() * 9 / 10]
+            << ", p99: " << all[all.size() * 99 / 100] << ", max: " << all.back() << std::endl;
+    return failed == 0 ? 0 : -1;
+}
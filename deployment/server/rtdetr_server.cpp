@@ -0,0 +1,328 @@
+#include <iostream>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <signal.h>
+
+#include "rtdetr.h"
+#include "rtdetr_utils.h"
+#include "rtdetr_scheduler.h"
+#include "rtdetr_router.h"
+#include "config.h"
+#include "protocol.h"
+#include "server_stats.h"
+
+// one warm process serving detections to local clients over a unix domain socket.
+// connection threads decode requests, a dynamic batcher groups them for the detector workers.
+// with several engines (server:MODELS) the router picks the engine of each request, every
+// engine has its own batcher and workers.
+
+typedef std::chrono::steady_clock Clock;
+
+struct Connection {
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+    int fd;
+    std::mutex write_mutex; // responses of a connection come from several workers
+    std::atomic<bool> finished {false}; // serve_connection returned, its thread can be joined
+};
+
+// connection threads are joined, not detached: they use the batchers, router and stats of main
+struct ConnectionThread {
+    std::shared_ptr<Connection> connection;
+    std::thread thread;
+};
+
+struct Request {
+    std::shared_ptr<Connection> connection;
+    uint64_t request_id;
+    cv::Mat image;
+    Clock::time_point arrival;
+    int engine = 0;         // router engine and the frames queued in front of it
+    int queued_ahead = 0;
+};
+
+// requests are released as a batch when max_batch are waiting, or when the oldest
+// waited max_delay_us
+class DynamicBatcher {
+    public:
+    DynamicBatcher(int max_batch, int max_delay_us) : m_max_batch(max_batch), m_max_delay(max_delay_us) {}
+
+    void push(Request&& request) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.push_back(std::move(request));
+        }
+        m_cond.notify_one();
+    }
+
+    // false when stopped
+    bool pop_batch(std::vector<Request>& batch) {
+        batch.clear();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        do {
+            m_cond.wait(lock, [this] { return !m_requests.empty() || m_stopped; });
+            if (m_requests.empty()) return false;
+
+            Clock::time_point deadline = m_requests.front().arrival + m_max_delay;
+            while ((int)m_requests.size() < m_max_batch && !m_stopped) {
+                if (m_cond.wait_until(lock, deadline) == std::cv_status::timeout) break;
+            }
+            // another worker may have taken the requests meanwhile
+        } while (m_requests.empty());
+
+        int count = std::min<int>(m_max_batch, m_requests.size());
+        for (int i = 0; i < count; ++i) {
+            batch.push_back(std::move(m_requests.front()));
+            m_requests.pop_front();
+        }
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cond.notify_all();
+    }
+
+    private:
+    int m_max_batch;
+    std::chrono::microseconds m_max_delay;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Request> m_requests;
+    bool m_stopped = false;
+};
+
+static std::atomic<bool> g_stopped(false);
+static int g_listen_fd = -1;
+
+static void on_signal(int) {
+    g_stopped = true;
+    // wakes up accept
+    shutdown(g_listen_fd, SHUT_RDWR);
+}
+
+static bool send_response(Connection& connection, uint64_t request_id, int status, const void* data,
+                        uint32_t count, size_t size) {
+    otl::response_header header;
+    header.magic = otl::kResponseMagic;
+    header.status = status;
+    header.request_id = request_id;
+    header.count = count;
+    header.reserved = 0;
+    std::lock_guard<std::mutex> lock(connection.write_mutex);
+    return otl::write_full(connection.fd, &header, sizeof(header)) && (size == 0 || otl::write_full(connection.fd, data, size));
+}
+
+// server stats with the resolution mix of the router
+static std::string stats_json(otl::ServerStats& stats, seeta::ResolutionRouter& router) {
+    std::string json = stats.to_json();
+    json.pop_back();
+    return json + ", \"resolutions\": " + router.to_json() + "}";
+}
+
+static void serve_connection(std::shared_ptr<Connection> connection,
+                            std::vector<std::unique_ptr<DynamicBatcher> >& batchers,
+                            seeta::ResolutionRouter& router, otl::ServerStats& stats, int imread_flags,
+                            uint64_t max_frame_bytes) {
+    std::vector<unsigned char> payload;
+    otl::request_header header;
+    while (!g_stopped && otl::read_full(connection->fd, &header, sizeof(header))) {
+        if (header.magic != otl::kRequestMagic) {
+            std::cerr << "bad request magic, close connection." << std::endl;
+            break;
+        }
+        Clock::time_point arrival = Clock::now();
+
+        // the payload of a request that is not read would be taken for the next header
+        bool known = header.type == otl::REQUEST_ENCODED || header.type == otl::REQUEST_RAW ||
+                (header.type == otl::REQUEST_STATS && header.payload_size == 0);
+        if (!known) {
+            std::cerr << "bad request type " << header.type << " with " << header.payload_size
+                    << " payload bytes, close connection." << std::endl;
+            break;
+        }
+        if (header.type == otl::REQUEST_STATS) {
+            std::string json = stats_json(stats, router);
+            if (!send_response(*connection, header.request_id, 0, json.data(), json.size(), json.size())) break;
+            continue;
+        }
+
+        Request request;
+        request.connection = connection;
+        request.request_id = header.request_id;
+        request.arrival = arrival;
+        // nothing is allocated for a request larger than a frame may be
+        if (header.payload_size > max_frame_bytes) {
+            std::cerr << "request of " << header.payload_size << " bytes is over MAX_FRAME_MB, close connection."
+                    << std::endl;
+            break;
+        }
+        if (header.type == otl::REQUEST_RAW) {
+            // read straight into the frame, the size in 64 bits does not wrap
+            bool valid = header.width > 0 && header.height > 0 && (header.channels == 1 || header.channels == 3) &&
+                    uint64_t(header.payload_size) == uint64_t(header.width) * uint64_t(header.height) * header.channels;
+            if (!valid) {
+                std::cerr << "bad raw frame header, close connection." << std::endl;
+                break;
+            }
+            request.image.create(header.height, header.width, CV_8UC(header.channels));
+            if (!otl::read_full(connection->fd, request.image.data, header.payload_size)) break;
+        } else {
+            // REQUEST_ENCODED
+            payload.resize(header.payload_size);
+            if (!otl::read_full(connection->fd, payload.data(), payload.size())) break;
+            request.image = cv::imdecode(payload, imread_flags);
+        }
+
+        if (request.image.empty()) {
+            if (!send_response(*connection, header.request_id, -1, nullptr, 0, 0)) break;
+            continue;
+        }
+        request.engine = router.route(header.resolution, request.queued_ahead);
+        batchers[request.engine]->push(std::move(request));
+    }
+    connection->finished = true;
+}
+
+// joins the threads of closed connections, all of them with stop after shutting their sockets down
+static void join_connections(std::vector<ConnectionThread>& connections, bool stop) {
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (stop) shutdown(it->connection->fd, SHUT_RDWR);
+        if (stop || it->connection->finished) {
+            it->thread.join();
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static void infer_worker(seeta::Rtdetr& rtdetr, DynamicBatcher& batcher, seeta::ResolutionRouter& router,
+                        otl::ServerStats& stats) {
+    std::vector<Request> batch;
+    std::vector<cv::Mat> images;
+    while (batcher.pop_batch(batch)) {
+        images.clear();
+        for (Request& request : batch) images.push_back(request.image);
+        int64_t errors = rtdetr.engine_errors();
+        std::vector<std::vector<detect_result> > results = rtdetr.detect_batch(images);
+        // a failed pass answers the whole batch with an error, its images can not be told apart
+        int status = rtdetr.engine_errors() != errors ? -1 : 0;
+        stats.add_batch(batch.size());
+
+        Clock::time_point done = Clock::now();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const std::vector<detect_result>& boxes = results[i];
+            send_response(*batch[i].connection, batch[i].request_id, status, boxes.data(), boxes.size(),
+                        boxes.size() * sizeof(detect_result));
+            int64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(done - batch[i].arrival).count();
+            stats.add_latency(latency_us);
+            router.done(batch[i].engine, batch[i].queued_ahead, latency_us);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Config config = ReadConfig(argc > 1 ? argv[1] : "config.ini");
+    std::cout << config << std::endl;
+
+    std::vector<std::string> models = seeta::parse_models(config.server.models);
+    if (models.empty()) models.push_back(config.model.detector_model);
+    int workers_num = std::max(1, config.parameter.workers_num);
+    int engines_num = models.size();
+    // workers_num workers per engine, one instance each, spread round robin over DEVICES
+    std::vector<std::unique_ptr<seeta::Rtdetr> > rtdetrs;
+    std::vector<int> devices = seeta::instance_devices(seeta::parse_devices(config.parameter.devices),
+                                                    workers_num * engines_num);
+    for (int i = 0; i < workers_num * engines_num; ++i) {
+        rtdetrs.emplace_back(new seeta::Rtdetr(models[i / workers_num].c_str(), config.parameter.detector_thresh,
+                                            devices[i]));
+        rtdetrs.back()->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms,
+                            config.parameter.max_det);
+        rtdetrs.back()->set_device_preprocess(config.parameter.device_preprocess);
+    }
+
+    // each engine letterboxes to its own input size, the router only needs the sizes
+    std::vector<int> resolutions;
+    std::vector<std::unique_ptr<DynamicBatcher> > batchers;
+    int stats_batch = 1;
+    for (int e = 0; e < engines_num; ++e) {
+        seeta::Rtdetr& rtdetr = *rtdetrs[e * workers_num];
+        nvinfer1::Dims dims = rtdetr.input_dims();
+        resolutions.push_back(std::max(dims.d[2], dims.d[3]));
+        // a batch larger than the engine batch takes several passes
+        int max_batch = config.server.max_batch > 0 ? config.server.max_batch : rtdetr.batch_size();
+        stats_batch = std::max(stats_batch, max_batch);
+        batchers.emplace_back(new DynamicBatcher(max_batch, config.server.max_delay_us));
+        std::cout << "Engine " << models[e] << ": input " << resolutions.back() << ", batch size: "
+                << rtdetr.batch_size() << ", max batch: " << max_batch << ", max delay: "
+                << config.server.max_delay_us << "us" << std::endl;
+    }
+    seeta::ResolutionRouter router(resolutions, config.server.router_queue_depth,
+                                int64_t(config.server.router_slo_ms) * 1000);
+
+    // the first pass of an instance sets up cuda and tensorrt lazily, it is taken before listening
+    // so the first requests and the latency estimates of the router do not pay for it
+    for (std::unique_ptr<seeta::Rtdetr>& rtdetr : rtdetrs) {
+        nvinfer1::Dims dims = rtdetr->input_dims();
+        cv::Mat blank(dims.d[2], dims.d[3], CV_8UC3, cv::Scalar(114, 114, 114));
+        rtdetr->detect_batch(std::vector<cv::Mat>(1, blank));
+    }
+    std::cout << "Warmed up " << rtdetrs.size() << " instances." << std::endl;
+
+    sockaddr_un address;
+    if (!otl::make_address(config.server.socket_path, address)) {
+        std::cerr << "socket path " << config.server.socket_path << " is too long." << std::endl;
+        return -1;
+    }
+    unlink(config.server.socket_path.c_str());
+    g_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (g_listen_fd < 0 || bind(g_listen_fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(g_listen_fd, 64) != 0) {
+        std::cerr << "listen on " << config.server.socket_path << " failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    std::cout << "Listening on " << config.server.socket_path << std::endl;
+
+    otl::ServerStats stats(stats_batch);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workers_num * engines_num; ++i) {
+        workers.emplace_back(infer_worker, std::ref(*rtdetrs[i]), std::ref(*batchers[i / workers_num]),
+                            std::ref(router), std::ref(stats));
+    }
+
+    int imread_flags = config.parameter.gray_input ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    uint64_t max_frame_bytes = uint64_t(std::max(1, config.server.max_frame_mb)) << 20;
+    std::vector<ConnectionThread> connections;
+    while (!g_stopped) {
+        int fd = accept(g_listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        join_connections(connections, false);
+        ConnectionThread connection;
+        connection.connection.reset(new Connection(fd));
+        connection.thread = std::thread(serve_connection, connection.connection, std::ref(batchers), std::ref(router),
+                                    std::ref(stats), imread_flags, max_frame_bytes);
+        connections.push_back(std::move(connection));
+    }
+
+    // no request is pushed after the batchers stop, the workers answer the queued ones
+    join_connections(connections, true);
+    for (std::unique_ptr<DynamicBatcher>& batcher : batchers) batcher->stop();
+    for (std::thread& worker : workers) worker.join();
+    close(g_listen_fd);
+    unlink(config.server.socket_path.c_str());
+    std::cout << "Server stats: " << stats_json(stats, router) << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef OTL_SERVER_STATS_H_
+#define OTL_SERVER_STATS_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <sstream>
+
+namespace otl {
+
+    // request latency in power of two microsecond buckets, and the sizes of the inferred batches
+    class ServerStats {
+        public:
+        static const int kLatencyBuckets = 32;
+
+        explicit ServerStats(int max_batch) : m_batch_counts(max_batch + 1, 0) {
+            for (int i = 0; i < kLatencyBuckets; ++i) m_latency_counts[i] = 0;
+        }
+
+        void add_latency(int64_t latency_us) {
+            int bucket = 0;
+            while (bucket < kLatencyBuckets - 1 && (int64_t(1) << (bucket + 1)) <= latency_us) bucket++;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_latency_counts[bucket]++;
+            m_latency_sum_us += latency_us;
+            m_requests++;
+        }
+
+        void add_batch(int batch) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (batch >= (int)m_batch_counts.size()) batch = m_batch_counts.size() - 1;
+            m_batch_counts[batch]++;
+            m_batches++;
+        }
+
+        std::string to_json() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::ostringstream out;
+            out << "{\"requests\": " << m_requests << ", \"batches\": " << m_batches;
+            out << ", \"latency_us\": {\"mean\": " << (m_requests ? m_latency_sum_us / m_requests : 0)
+                << ", \"p50\": " << percentile(0.5) << ", \"p99\": " << percentile(0.99) << ", \"buckets\": {";
+            bool first = true;
+            for (int i = 0; i < kLatencyBuckets; ++i) {
+                if (m_latency_counts[i] == 0) continue;
+                // key is the bucket upper bound
+                out << (first ? "" : ", ") << "\"" << (int64_t(1) << (i + 1)) << "\": " << m_latency_counts[i];
+                first = false;
+            }
+            out << "}}, \"batch_size\": {";
+            first = true;
+            uint64_t batched = 0;
+            for (size_t i = 1; i < m_batch_counts.size(); ++i) {
+                batched += i * m_batch_counts[i];
+                if (m_batch_counts[i] == 0) continue;
+                out << (first ? "" : ", ") << "\"" << i << "\": " << m_batch_counts[i];
+                first = false;
+            }
+            out << "}, \"mean_batch_size\": " << (m_batches ? batched * 1.0 / m_batches : 0.0) << "}";
+            return out.str();
+        }
+
+        private:
+        // upper bound of the bucket holding the quantile
+        int64_t percentile(double quantile) const {
+            uint64_t target = uint64_t(quantile * m_requests);
+            uint64_t seen = 0;
+            for (int i = 0; i < kLatencyBuckets; ++i) {
+                seen += m_latency_counts[i];
+                if (seen > target) return int64_t(1) << (i + 1);
+            }
+            return 0;
+        }
+
+        std::mutex m_mutex;
+        uint64_t m_latency_counts[kLatencyBuckets];
+        std::vector<uint64_t> m_batch_counts;
+        uint64_t m_requests = 0;
+        uint64_t m_batches = 0;
+        int64_t m_latency_sum_us = 0;
+    };
+}
+
+#endif // OTL_SERVER_STATS_H_
@@ -0,0 +1,205 @@
+#include "rtdetr.h"
+#include "rtdetr_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+
+// seeta::Rtdetr without engine and gpu, linked into test_mock in place of the Rtdetr library so the
+// pipelines run unchanged on machines without a gpu (rtdetr_loadgen --exe ./test_mock).
+// DETECTOR_MODEL = mock:input_size:engine_us[:batch], e.g. mock:640:8000.
+// the host work is real: decoding, letterboxing and normalizing into the host input buffer.
+// an engine pass sleeps engine_us on one simulated device, so passes of all instances queue up
+// like on one gpu. every image gets the same few boxes, scaled to its size
+namespace seeta {
+
+    static const int kMockBoxes = 8;
+    static std::mutex g_mock_device;
+    static int64_t g_mock_engine_us = 8000;
+
+    static void mock_engine_pass() {
+        std::lock_guard<std::mutex> lock(g_mock_device);
+        std::this_thread::sleep_for(std::chrono::microseconds(g_mock_engine_us));
+    }
+
+    static void mock_results(int image_width, int image_height, float conf_thresh, int max_det,
+                            std::vector<detect_result>& results) {
+        results.clear();
+        for (int k = 0; k < kMockBoxes; ++k) {
+            detect_result result;
+            result.box.x = image_width * (k + 1) / float(kMockBoxes + 2);
+            result.box.y = image_height * ((k % 3) + 1) / 5.0f;
+            result.box.width = image_width / 12.0f;
+            result.box.height = image_height / 10.0f;
+            result.score = 0.9f - 0.08f * k;
+            result.cls = k % 80;
+            result.track_id = -1;
+            if (result.score >= conf_thresh && (max_det <= 0 || (int)results.size() < max_det)) results.push_back(result);
+        }
+    }
+
+    Rtdetr::Rtdetr(const char* engine_file, float confidence_thresh, int device) {
+        int input_size = 640;
+        int engine_us = 8000;
+        int batch = 1;
+        if (sscanf(engine_file, "mock:%d:%d:%d", &input_size, &engine_us, &batch) < 2) {
+            std::cerr << "mock engine " << engine_file << " is not mock:input_size:engine_us[:batch], use mock:"
+                    << input_size << ":" << engine_us << std::endl;
+        }
+        g_mock_engine_us = engine_us;
+
+        m_runtime = nullptr;
+        m_engine = nullptr;
+        m_context = nullptr;
+        m_input_dims.nbDims = 4;
+        m_input_dims.d[0] = batch > 0 ? batch : 1;
+        m_input_dims.d[1] = 3;
+        m_input_dims.d[2] = input_size;
+        m_input_dims.d[3] = input_size;
+        m_output_dims.nbDims = 3;
+        m_output_dims.d[0] = m_input_dims.d[0];
+        m_output_dims.d[1] = 300;
+        m_output_dims.d[2] = 84;
+        m_cuda_input_size = m_input_dims.d[0] * 3 * input_size * input_size;
+        m_cuda_output_size = m_output_dims.d[0] * 300 * 84;
+        m_cuda_input_mem = nullptr;
+        m_cuda_output_mem = nullptr;
+        m_host_input_mem = new float[m_cuda_input_size];
+        m_host_output_mem = nullptr;
+        m_device = device < 0 ? 0 : device;
+        m_conf_thresh = confidence_thresh;
+        std::cout << "Mock engine: input " << input_size << ", batch " << m_input_dims.d[0] << ", "
+                << engine_us << "us per pass" << std::endl;
+    }
+
+    Rtdetr::~Rtdetr() {
+        delete[] (float*)m_host_input_mem;
+        delete[] (unsigned char*)m_host_uint8_mem;
+    }
+
+    detect_result_group Rtdetr::detect(unsigned char* image, int image_width, int image_height, bool debug) {
+        return detect(image, image_width, image_height, 3, debug);
+    }
+
+    detect_result_group Rtdetr::detect(unsigned char* image, int image_width, int image_height, int channels,
+                                    bool debug) {
+        cv::Mat origin_mat(image_height, image_width, CV_8UC(channels), (void*)image);
+        float scale_x,scale_y;
+        int padding_top, padding_bottom, padding_left, padding_right;
+        if (m_uint8_input && !m_device_preprocess) {
+            seeta::preprocess_uint8(origin_mat, m_input_dims.d[3], m_input_dims.d[2],
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right,
+                        true, (unsigned char*)m_host_uint8_mem);
+        } else if (!m_device_preprocess) {
+            seeta::preprocess(origin_mat, m_input_dims.d[3], m_input_dims.d[2],
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right,
+                        true, (float*)m_host_input_mem);
+        }
+        mock_engine_pass();
+        mock_results(image_width, image_height, m_conf_thresh, m_nms_max_det, m_results);
+
+        detect_result_group result_group;
+        result_group.size = m_results.size();
+        result_group.data = m_results.data();
+        return result_group;
+    }
+
+    detect_result_group Rtdetr::detect_encoded(const uint8_t* bytes, size_t len, int imread_flags, bool debug) {
+        cv::Mat image = m_decode_buffer.decode(bytes, len, imread_flags);
+        if (image.empty()) {
+            detect_result_group result_group;
+            result_group.size = -1;
+            result_group.data = nullptr;
+            return result_group;
+        }
+        return detect(image.data, image.cols, image.rows, image.channels(), debug);
+    }
+
+    int64_t Rtdetr::decode_allocations() const {
+        return m_decode_buffer.allocations();
+    }
+
+    std::vector<detect_result> Rtdetr::detect(float* chw_data, int image_width, int image_height) {
+        mock_engine_pass();
+        mock_results(image_width, image_height, m_conf_thresh, m_nms_max_det, m_results);
+        return m_results;
+    }
+
+    std::vector<detect_result> Rtdetr::detect_letterboxed(const unsigned char* hwc_data, int channels,
+                                            int image_width, int image_height) {
+        mock_engine_pass();
+        mock_results(image_width, image_height, m_conf_thresh, m_nms_max_det, m_results);
+        return m_results;
+    }
+
+    // one pass for the whole frame, the tiles are not simulated
+    detect_result_group Rtdetr::detect_tiles(unsigned char* image, int image_width, int image_height,
+                                    const tile_config& config, bool debug) {
+        return detect(image, image_width, image_height, 3, debug);
+    }
+
+    detect_result_group Rtdetr::detect_tiles(unsigned char* image, int image_width, int image_height, int channels,
+                                    const tile_config& config, bool debug) {
+        return detect(image, image_width, image_height, channels, debug);
+    }
+
+    std::vector<std::vector<detect_result> > Rtdetr::detect_batch(const std::vector<cv::Mat>& images) {
+        int batch = batch_size();
+        int input_size = m_cuda_input_size / batch;
+        float scale_x,scale_y;
+        int padding_top, padding_bottom, padding_left, padding_right;
+        std::vector<std::vector<detect_result> > results(images.size());
+        for (size_t begin = 0; begin < images.size(); begin += batch) {
+            int count = std::min(batch, int(images.size() - begin));
+            for (int b = 0; b < count && !m_device_preprocess; ++b) {
+                seeta::preprocess(images[begin + b], m_input_dims.d[3], m_input_dims.d[2],
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right,
+                            true, (float*)m_host_input_mem + b * input_size);
+            }
+            mock_engine_pass();
+            for (int b = 0; b < count; ++b) {
+                const cv::Mat& image = images[begin + b];
+                mock_results(image.cols, image.rows, m_conf_thresh, m_nms_max_det, results[begin + b]);
+            }
+        }
+        return results;
+    }
+
+    int Rtdetr::device() const {
+        return m_device;
+    }
+
+    int64_t Rtdetr::engine_errors() const {
+        return m_engine_errors.load(std::memory_order_relaxed);
+    }
+
+    nvinfer1::Dims Rtdetr::input_dims() const {
+        return m_input_dims;
+    }
+
+    int Rtdetr::batch_size() const {
+        return m_input_dims.d[0] > 0 ? m_input_dims.d[0] : 1;
+    }
+
+    void Rtdetr::set_nms(float iou_thresh, bool agnostic, int max_det) {
+        m_nms_iou_thresh = iou_thresh;
+        m_nms_agnostic = agnostic;
+        m_nms_max_det = max_det;
+    }
+
+    void Rtdetr::set_uint8_input(bool enable) {
+        m_uint8_input = enable;
+        if (enable && m_host_uint8_mem == nullptr) {
+            m_host_uint8_mem = new unsigned char[3 * m_input_dims.d[2] * m_input_dims.d[3]];
+        }
+    }
+
+    // the letter box runs on the simulated device, no host preprocessing
+    void Rtdetr::set_device_preprocess(bool enable) {
+        m_device_preprocess = enable;
+    }
+}
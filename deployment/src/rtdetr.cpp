@@ -1,5 +1,6 @@
 #include "rtdetr.h"
 #include "rtdetr_utils.h"
+#include "rtdetr_kernels.h"
 
 #include <stdio.h>
 #include <iostream>
@@ -65,8 +66,12 @@ namespace seeta {
     }
 
 
-    Rtdetr::Rtdetr(const char* engine_file, float confidence_thresh) {
+    Rtdetr::Rtdetr(const char* engine_file, float confidence_thresh, int device) {
         m_conf_thresh = confidence_thresh;
+        // engine, buffers and pinned host memory live on the device of the instance
+        if (device < 0) cudaGetDevice(&device);
+        m_device = device;
+        bind_device();
 
         // init logger
         m_logger.reset(new Logger());
@@ -121,9 +126,15 @@ namespace seeta {
         // std::cout << std::endl;
         // std::cout << "cuda output size: " << m_cuda_output_size << std::endl;
 
+        // fp16 engines exported with half io bindings
+        m_input_half = m_engine->getBindingDataType(0) == nvinfer1::DataType::kHALF;
+        m_output_half = m_engine->getBindingDataType(1) == nvinfer1::DataType::kHALF;
+        size_t input_elem_size = m_input_half ? sizeof(uint16_t) : sizeof(float);
+        size_t output_elem_size = m_output_half ? sizeof(uint16_t) : sizeof(float);
+
         // alloc mem for cuda and host
-        cudaMalloc(&m_cuda_input_mem, 1 * m_cuda_input_size * sizeof(float));
-        cudaMalloc(&m_cuda_output_mem, 1 * m_cuda_output_size * sizeof(float));
+        cudaMalloc(&m_cuda_input_mem, 1 * m_cuda_input_size * input_elem_size);
+        cudaMalloc(&m_cuda_output_mem, 1 * m_cuda_output_size * output_elem_size);
         // std::cout << "m_cuda_input_mem ptr:" << m_cuda_input_mem << std::endl;
         // std::cout << "m_cuda_ouput_mem ptr:" << m_cuda_output_mem << std::endl;
 
@@ -131,8 +142,8 @@ namespace seeta {
         // auto deleter = [](float* data) {if (data) delete[] data;};
         // m_host_input_mem.reset(new float[1 * m_cuda_input_size]);
         // m_host_output_mem.reset(new float[1 * m_cuda_output_size]);
-        cudaMallocHost((void**)&m_host_input_mem, 1 * m_cuda_input_size * sizeof(float));
-        cudaMallocHost((void**)&m_host_output_mem, 1 * m_cuda_output_size * sizeof(float));
+        cudaMallocHost((void**)&m_host_input_mem, 1 * m_cuda_input_size * input_elem_size);
+        cudaMallocHost((void**)&m_host_output_mem, 1 * m_cuda_output_size * output_elem_size);
 
         // std::cout << "m_host_input_mem ptr:" << m_host_input_mem << std::endl;
         // std::cout << "m_host_output_mem ptr:" << m_host_output_mem << std::endl;
@@ -144,6 +155,7 @@ namespace seeta {
     }
 
     Rtdetr::~Rtdetr() {
+        bind_device();
         // free cuda malloc memory
         if (m_cuda_input_mem)
             cudaFree(m_cuda_input_mem);
@@ -158,97 +170,98 @@ namespace seeta {
         if (m_host_output_mem)
             cudaFreeHost(m_host_output_mem);
 
+        set_uint8_input(false);
+        set_device_preprocess(false);
+
         // runtime engine contest
         m_context->destroy();
         m_engine->destroy();
         m_runtime->destroy();
     }
 
-    static std::vector<float> cxcywh_to_xyxy(const std::vector<float>& box) {
-        float x1 = box[0] - box[2] / 2.0f;
-        float y1 = box[1] - box[3] / 2.0;
-        float x2 = box[0] + box[2] / 2.0f;
-        float y2 = box[1] + box[3] / 2.0f;
-        std::vector<float> results = {x1, y1, x2, y2};
-        return results;
+    detect_result_group Rtdetr::detect(unsigned char* image, int image_width, int image_height, bool debug) {
+        return detect(image, image_width, image_height, 3, debug);
     }
 
-    // post processing to get results
-    // raw_output num_queries x (4 + cls_num)
-    static void postprocess(float* raw_output, int num_queries, int cls_num, int origin_image_width, 
-                int origin_image_height, float conf_thresh, std::vector<detect_result>& results) 
-    {
-        // results.clear();
-        // std::cout << "num_queries: " << num_queries << std::endl;
-        // std::cout << "cls_num: " << cls_num << std::endl;
-        // for (int i=0;i<3;++i) {
-        //     std::cout << i << "th output:" << raw_output[0 * 84 + i] << " ";
-        // }
-
-        for (int i = 0; i < num_queries; ++i) {
-            float* output = raw_output + i * (4 + cls_num);
-            float cx = output[0];
-            float cy = output[1];
-            float width = output[2];
-            float height = output[3];
-            float* scores = output + 4;
-            int max_idx = 0;
-            float max_score = 0.0f;
-
-            for (int j = 0; j < cls_num; j++) {
-                // std::cout << "score " << j << ":" << scores[j] << " ";
-                if (scores[j] > max_score) {
-                    max_score = scores[j];
-                    max_idx = j;
-                }
-            }
-            // std::cout <<std::endl;
-
-            // only collect result which confidence is greater than thresh
-            // std::cout << "max_score: " << max_score << std::endl;
-            if (max_score >= conf_thresh) {
-                detect_result result;
-                result.score = max_score;
-                result.cls = max_idx;
-                std::vector<float> xyxy = cxcywh_to_xyxy(std::vector<float>{cx, cy, width, height});
-                // decode location
-                xyxy[0] = std::min(std::max(0.0f, xyxy[0] * origin_image_width), origin_image_width - 1.0f);
-                xyxy[1] = std::min(std::max(0.0f, xyxy[1] * origin_image_height), origin_image_height - 1.0f);
-                xyxy[2] = std::min(std::max(0.0f, xyxy[2] * origin_image_width), origin_image_width - 1.0f);
-                xyxy[3] = std::min(std::max(0.0f, xyxy[3] * origin_image_height), origin_image_height - 1.0f);
-                result.box.x = (xyxy[0]);
-                result.box.y = (xyxy[1]);
-                result.box.width = (xyxy[2] - xyxy[0]);
-                result.box.height = (xyxy[3] - xyxy[1]);
-                // std::cout << "obj width:" << result.box.width << std::endl;
-                // std::cout << "obj height:" << result.box.height << std::endl;
-                if ((result.box.width > 0) && (result.box.height > 0)) {
-                    results.emplace_back(result);
-                }
+    detect_result_group Rtdetr::detect(unsigned char* image, int image_width, int image_height, int channels,
+                                    bool debug) {
+        bind_device();
+        cv::Mat origin_mat(image_height, image_width, CV_8UC(channels), (void*)image);
+        float scale_x,scale_y;
+        int padding_top, padding_bottom, padding_left, padding_right;
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            if (m_device_preprocess) {
+                // only the letter box geometry on the host, the frame is processed on the device
+                letterbox_slot(origin_mat, 0);
+            } else if (m_uint8_input) {
+                // letterbox only, normalization runs on the device
+                seeta::preprocess_uint8(origin_mat, m_input_dims.d[3], m_input_dims.d[2],
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, (unsigned char*)m_host_uint8_mem);
+            } else if (m_input_half) {
+                seeta::preprocess_half(origin_mat, m_input_dims.d[3], m_input_dims.d[2],
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, (uint16_t*)m_host_input_mem);
+            } else {
+                seeta::preprocess(origin_mat, m_input_dims.d[3], m_input_dims.d[2],
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, (float*)m_host_input_mem);
             }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double, std::milli> duration = end - start;
+            if (debug)
+                std::cout << "processing spent " << duration.count() << "ms" << std::endl; 
+        }
+
+        // copy host data to cuda
+        if (m_device_preprocess) {
+            // already in the input binding
+        } else if (m_uint8_input) {
+            upload_uint8((unsigned char*)m_host_uint8_mem, channels);
+        } else {
+            size_t input_elem_size = m_input_half ? sizeof(uint16_t) : sizeof(float);
+            cudaMemcpy(m_cuda_input_mem, (void*)m_host_input_mem, 1 * m_cuda_input_size * input_elem_size, cudaMemcpyHostToDevice);
+        }
 
+        detect_result_group result_group;
+        if (!infer_and_postprocess(image_width, image_height, debug)) {
+            result_group.size = -1;
+            result_group.data = nullptr;
+            return result_group;
         }
+        result_group.size = m_results.size();
+        result_group.data = m_results.data();
+        return result_group;
     }
 
-    detect_result_group Rtdetr::detect(unsigned char* image, int image_width, int image_height, bool debug) {
-        cv::Mat origin_mat(image_height, image_width, CV_8UC3, (void*)image);
-        float scale_x,scale_y;
-        int padding_top, padding_bottom, padding_left, padding_right;
+    detect_result_group Rtdetr::detect_encoded(const uint8_t* bytes, size_t len, int imread_flags, bool debug) {
+        cv::Mat image;
         {
             auto start = std::chrono::high_resolution_clock::now();
-            seeta::preprocess(origin_mat, m_input_dims.d[3], m_input_dims.d[2],
-                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
-                        true, (float*)m_host_input_mem);
+            image = m_decode_buffer.decode(bytes, len, imread_flags);
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double, std::milli> duration = end - start;
             if (debug)
-                std::cout << "processing spent " << duration.count() << "ms" << std::endl; 
+                std::cout << "decoding spent " << duration.count() << "ms" << std::endl; 
+        }
+        if (image.empty()) {
+            detect_result_group result_group;
+            result_group.size = -1;
+            result_group.data = nullptr;
+            return result_group;
         }
+        return detect(image.data, image.cols, image.rows, image.channels(), debug);
+    }
 
-        // copy host data to cuda
-        cudaMemcpy(m_cuda_input_mem, (void*)m_host_input_mem, 1 * m_cuda_input_size * sizeof(float), cudaMemcpyHostToDevice);
-        
+    int64_t Rtdetr::decode_allocations() const {
+        return m_decode_buffer.allocations();
+    }
+
+    bool Rtdetr::infer_and_postprocess(int image_width, int image_height, bool debug) {
         void* bindings[] = {m_cuda_input_mem, m_cuda_output_mem};
+        // clear results before decode, a failed pass leaves the output of the previous one
+        m_results.clear();
         // inference
         {
             auto start = std::chrono::high_resolution_clock::now();
@@ -256,7 +269,7 @@ namespace seeta {
             // m_context->enqueueV2(bindings, 0, nullptr);
 
             // sync running 
-            m_context->executeV2(bindings);
+            if (!execute(bindings)) return false;
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double, std::milli> duration = end - start;
             if (debug)
@@ -265,20 +278,132 @@ namespace seeta {
 
         // copy cuda to host
         // std::cout << "Begin to copy results to host." << std::endl;
-        cudaMemcpy((void*)m_host_output_mem, m_cuda_output_mem, 1 * m_cuda_output_size * sizeof(float), cudaMemcpyDeviceToHost);
+        size_t output_elem_size = m_output_half ? sizeof(uint16_t) : sizeof(float);
+        cudaMemcpy((void*)m_host_output_mem, m_cuda_output_mem, 1 * m_cuda_output_size * output_elem_size, cudaMemcpyDeviceToHost);
         // std::cout << "Copy output succeed." << std::endl;
 
-        // clear results before decode
-        m_results.clear();
         {
             auto start = std::chrono::high_resolution_clock::now();
-            postprocess((float*)m_host_output_mem, m_output_dims.d[1], m_output_dims.d[2] - 4, 
+            postprocess(float_output(0, m_cuda_output_size), m_output_dims.d[1], m_output_dims.d[2] - 4, 
                 image_width, image_height, m_conf_thresh, m_results);
+            nms(m_results, m_nms_iou_thresh, m_nms_agnostic, m_nms_max_det);
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double, std::milli> duration = end - start;
             if (debug)
                 std::cout << "postprocessing spent " << duration.count() << "ms" << std::endl; 
         }
+        return true;
+    }
+
+    std::vector<detect_result> Rtdetr::detect(float* chw_data, int image_width, int image_height) {
+        bind_device();
+        // copy host data to cuda
+        if (m_input_half) {
+            // float producers (pipelines) on a fp16 engine, narrowed on the host to halve the copy
+            float_to_half(chw_data, (uint16_t*)m_host_input_mem, m_cuda_input_size);
+            cudaMemcpy(m_cuda_input_mem, m_host_input_mem, 1 * m_cuda_input_size * sizeof(uint16_t), cudaMemcpyHostToDevice);
+        } else {
+            cudaMemcpy(m_cuda_input_mem, (void*)chw_data, 1 * m_cuda_input_size * sizeof(float), cudaMemcpyHostToDevice);
+        }
+        infer_and_postprocess(image_width, image_height, false);
+        return m_results;
+    }
+
+    std::vector<detect_result> Rtdetr::detect_letterboxed(const unsigned char* hwc_data, int channels,
+                                            int image_width, int image_height) {
+        bind_device();
+        upload_uint8(hwc_data, channels);
+        infer_and_postprocess(image_width, image_height, false);
+        return m_results;
+    }
+
+    void Rtdetr::upload_uint8(const unsigned char* hwc_data, int channels) {
+        int width = m_input_dims.d[3];
+        int height = m_input_dims.d[2];
+        // a quarter of the float copy, a twelfth for gray images
+        cudaMemcpy(m_cuda_uint8_mem, (const void*)hwc_data, width * height * channels, cudaMemcpyHostToDevice);
+        if (m_input_half) {
+            normalize_half_gpu((const uint8_t*)m_cuda_uint8_mem, width, height, channels, (uint16_t*)m_cuda_input_mem);
+        } else {
+            normalize_gpu((const uint8_t*)m_cuda_uint8_mem, width, height, channels, (float*)m_cuda_input_mem);
+        }
+    }
+
+    detect_result_group Rtdetr::detect_tiles(unsigned char* image, int image_width, int image_height, 
+                                    const tile_config& config, bool debug) {
+        return detect_tiles(image, image_width, image_height, 3, config, debug);
+    }
+
+    detect_result_group Rtdetr::detect_tiles(unsigned char* image, int image_width, int image_height, int channels,
+                                    const tile_config& config, bool debug) {
+        bind_device();
+        cv::Mat origin_mat(image_height, image_width, CV_8UC(channels), (void*)image);
+        int model_width = m_input_dims.d[3];
+        int tile_size = config.tile_size > 0 ? config.tile_size : model_width;
+        if (!valid_tile_overlap(tile_size, config.overlap)) {
+            std::cerr << "tile overlap " << config.overlap << " is not in [0, " << tile_size << ")" << std::endl;
+            detect_result_group result_group;
+            result_group.size = -1;
+            result_group.data = nullptr;
+            return result_group;
+        }
+
+        std::vector<cv::Rect> tiles = make_tiles(image_width, image_height, tile_size, config.overlap);
+        if (config.full_frame && tiles.size() > 1) {
+            tiles.push_back(cv::Rect(0, 0, image_width, image_height));
+        }
+
+        int batch = batch_size();
+        int input_size = m_cuda_input_size / batch;
+        int output_size = m_cuda_output_size / batch;
+        size_t input_elem_size = m_input_half ? sizeof(uint16_t) : sizeof(float);
+        size_t output_elem_size = m_output_half ? sizeof(uint16_t) : sizeof(float);
+        void* bindings[] = {m_cuda_input_mem, m_cuda_output_mem};
+
+        // clear results before decode
+        m_results.clear();
+        std::vector<detect_result> tile_results;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t begin = 0; begin < tiles.size(); begin += batch) {
+            int count = std::min(batch, int(tiles.size() - begin));
+            for (int b = 0; b < count; ++b) {
+                preprocess_slot(origin_mat(tiles[begin + b]), b);
+            }
+
+            // only copy the filled part of the batch
+            if (!m_device_preprocess)
+                cudaMemcpy(m_cuda_input_mem, m_host_input_mem, count * input_size * input_elem_size, cudaMemcpyHostToDevice);
+            if (!execute(bindings)) {
+                // boxes of the other tiles would pass for the whole frame
+                m_results.clear();
+                detect_result_group result_group;
+                result_group.size = -1;
+                result_group.data = nullptr;
+                return result_group;
+            }
+            cudaMemcpy(m_host_output_mem, m_cuda_output_mem, count * output_size * output_elem_size, cudaMemcpyDeviceToHost);
+
+            // map boxes back to frame coordinates
+            for (int b = 0; b < count; ++b) {
+                const cv::Rect& tile = tiles[begin + b];
+                tile_results.clear();
+                postprocess(float_output(b * output_size, output_size), m_output_dims.d[1], m_output_dims.d[2] - 4, 
+                    tile.width, tile.height, m_conf_thresh, tile_results);
+                for (detect_result& result : tile_results) {
+                    result.box.x += tile.x;
+                    result.box.y += tile.y;
+                    m_results.push_back(result);
+                }
+            }
+        }
+        if (tiles.size() > 1) {
+            merge_tile_results(m_results, config.merge_thresh);
+        }
+        nms(m_results, m_nms_iou_thresh, m_nms_agnostic, m_nms_max_det);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> duration = end - start;
+        if (debug)
+            std::cout << tiles.size() << " tiles spent " << duration.count() << "ms" << std::endl; 
 
         detect_result_group result_group;
         result_group.size = m_results.size();
@@ -286,25 +411,175 @@ namespace seeta {
         return result_group;
     }
 
-    std::vector<detect_result> Rtdetr::detect(float* chw_data, int image_width, int image_height) {
-        // copy host data to cuda
-        cudaMemcpy(m_cuda_input_mem, (void*)chw_data, 1 * m_cuda_input_size * sizeof(float), cudaMemcpyHostToDevice);
+    std::vector<std::vector<detect_result> > Rtdetr::detect_batch(const std::vector<cv::Mat>& images) {
+        bind_device();
+        int batch = batch_size();
+        int input_size = m_cuda_input_size / batch;
+        int output_size = m_cuda_output_size / batch;
+        size_t input_elem_size = m_input_half ? sizeof(uint16_t) : sizeof(float);
+        size_t output_elem_size = m_output_half ? sizeof(uint16_t) : sizeof(float);
         void* bindings[] = {m_cuda_input_mem, m_cuda_output_mem};
-        // inference
-        // sync running 
-        m_context->executeV2(bindings);
-        // copy cuda to host
-        cudaMemcpy((void*)m_host_output_mem, m_cuda_output_mem, 1 * m_cuda_output_size * sizeof(float), cudaMemcpyDeviceToHost);
-        // clear results before decode
-        m_results.clear();
-        {
-            postprocess((float*)m_host_output_mem, m_output_dims.d[1], m_output_dims.d[2] - 4, 
-                image_width, image_height, m_conf_thresh, m_results);
+
+        std::vector<std::vector<detect_result> > results(images.size());
+        for (size_t begin = 0; begin < images.size(); begin += batch) {
+            int count = std::min(batch, int(images.size() - begin));
+            for (int b = 0; b < count; ++b) {
+                preprocess_slot(images[begin + b], b);
+            }
+
+            if (!m_device_preprocess)
+                cudaMemcpy(m_cuda_input_mem, m_host_input_mem, count * input_size * input_elem_size, cudaMemcpyHostToDevice);
+            // the images of a failed pass keep empty results, engine_errors() tells them apart
+            if (!execute(bindings)) continue;
+            cudaMemcpy(m_host_output_mem, m_cuda_output_mem, count * output_size * output_elem_size, cudaMemcpyDeviceToHost);
+
+            for (int b = 0; b < count; ++b) {
+                const cv::Mat& image = images[begin + b];
+                std::vector<detect_result>& image_results = results[begin + b];
+                postprocess(float_output(b * output_size, output_size), m_output_dims.d[1], m_output_dims.d[2] - 4, 
+                    image.cols, image.rows, m_conf_thresh, image_results);
+                nms(image_results, m_nms_iou_thresh, m_nms_agnostic, m_nms_max_det);
+            }
         }
-        return m_results;
+        return results;
+    }
+
+    // preprocess into batch slot of the host input, in the input binding type.
+    // device preprocessing writes the slot of the input binding instead
+    void Rtdetr::preprocess_slot(const cv::Mat& image, int slot) {
+        int model_width = m_input_dims.d[3];
+        int model_height = m_input_dims.d[2];
+        int input_size = m_cuda_input_size / batch_size();
+        float scale_x,scale_y;
+        int padding_top, padding_bottom, padding_left, padding_right;
+        if (m_device_preprocess) {
+            letterbox_slot(image, slot);
+        } else if (m_input_half) {
+            seeta::preprocess_half(image, model_width, model_height,
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                        true, (uint16_t*)m_host_input_mem + slot * input_size);
+        } else {
+            seeta::preprocess(image, model_width, model_height,
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                        true, (float*)m_host_input_mem + slot * input_size);
+        }
+    }
+
+    // uploads the frame (rows may be strided, e.g. a tile) and letterboxes it into batch slot of the
+    // input binding. the tables are rebuilt when the frame size changes, a video keeps its tables
+    void Rtdetr::letterbox_slot(const cv::Mat& image, int slot) {
+        float scale_x,scale_y;
+        int padding_top, padding_bottom, padding_left, padding_right;
+        letterbox_geometry geometry = make_letterbox_geometry(image, m_input_dims.d[3], m_input_dims.d[2],
+                        scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, true);
+
+        size_t row_size = image.cols * image.elemSize();
+        size_t frame_size = row_size * image.rows;
+        if (frame_size > m_cuda_frame_size) {
+            if (m_cuda_frame_mem) cudaFree(m_cuda_frame_mem);
+            cudaMalloc(&m_cuda_frame_mem, frame_size);
+            m_cuda_frame_size = frame_size;
+        }
+        cudaMemcpy2D(m_cuda_frame_mem, row_size, image.data, image.step, row_size, image.rows, cudaMemcpyHostToDevice);
+
+        if (!(geometry == m_table_geometry)) {
+            size_t table_size = letterbox_tables_size(geometry);
+            if (table_size > m_table_size) {
+                if (m_cuda_table_mem) cudaFree(m_cuda_table_mem);
+                if (m_host_table_mem) cudaFreeHost(m_host_table_mem);
+                cudaMalloc(&m_cuda_table_mem, table_size);
+                cudaMallocHost(&m_host_table_mem, table_size);
+                m_table_size = table_size;
+            }
+            // synchronous copy, the kernels of the previous size have finished with the old tables
+            build_letterbox_tables(geometry, m_host_table_mem);
+            cudaMemcpy(m_cuda_table_mem, m_host_table_mem, table_size, cudaMemcpyHostToDevice);
+            m_table_geometry = geometry;
+        }
+
+        letterbox_tables tables = letterbox_tables_at(geometry, m_cuda_table_mem);
+        int input_size = m_cuda_input_size / batch_size();
+        if (m_input_half) {
+            letterbox_half_gpu((const uint8_t*)m_cuda_frame_mem, row_size, geometry, tables,
+                            (uint16_t*)m_cuda_input_mem + slot * input_size);
+        } else {
+            letterbox_gpu((const uint8_t*)m_cuda_frame_mem, row_size, geometry, tables,
+                            (float*)m_cuda_input_mem + slot * input_size);
+        }
+    }
+
+    // size floats of the host output at offset, fp16 outputs are widened into m_output_float
+    float* Rtdetr::float_output(int offset, int size) {
+        if (!m_output_half) return (float*)m_host_output_mem + offset;
+        m_output_float.resize(size);
+        half_to_float((const uint16_t*)m_host_output_mem + offset, m_output_float.data(), size);
+        return m_output_float.data();
+    }
+
+    int Rtdetr::device() const {
+        return m_device;
+    }
+
+    // the current device is per thread, any thread may call an instance
+    void Rtdetr::bind_device() {
+        cudaSetDevice(m_device);
+    }
+
+    int64_t Rtdetr::engine_errors() const {
+        return m_engine_errors.load(std::memory_order_relaxed);
+    }
+
+    bool Rtdetr::execute(void** bindings) {
+        if (m_context->executeV2(bindings)) return true;
+        if (m_engine_errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+            std::cerr << "engine execution failed." << std::endl;
+        }
+        return false;
     }
 
     nvinfer1::Dims Rtdetr::input_dims() const {
         return m_input_dims;
     }
+
+    int Rtdetr::batch_size() const {
+        return m_input_dims.d[0] > 0 ? m_input_dims.d[0] : 1;
+    }
+
+    void Rtdetr::set_nms(float iou_thresh, bool agnostic, int max_det) {
+        m_nms_iou_thresh = iou_thresh;
+        m_nms_agnostic = agnostic;
+        m_nms_max_det = max_det;
+    }
+
+    void Rtdetr::set_uint8_input(bool enable) {
+        bind_device();
+        m_uint8_input = enable;
+        if (enable && m_cuda_uint8_mem == nullptr) {
+            size_t size = 3 * m_input_dims.d[2] * m_input_dims.d[3];
+            cudaMalloc(&m_cuda_uint8_mem, size);
+            cudaMallocHost(&m_host_uint8_mem, size);
+        }
+        if (!enable && m_cuda_uint8_mem != nullptr) {
+            cudaFree(m_cuda_uint8_mem);
+            cudaFreeHost(m_host_uint8_mem);
+            m_cuda_uint8_mem = nullptr;
+            m_host_uint8_mem = nullptr;
+        }
+    }
+
+    void Rtdetr::set_device_preprocess(bool enable) {
+        bind_device();
+        m_device_preprocess = enable;
+        if (!enable) {
+            if (m_cuda_frame_mem) cudaFree(m_cuda_frame_mem);
+            if (m_cuda_table_mem) cudaFree(m_cuda_table_mem);
+            if (m_host_table_mem) cudaFreeHost(m_host_table_mem);
+            m_cuda_frame_mem = nullptr;
+            m_cuda_table_mem = nullptr;
+            m_host_table_mem = nullptr;
+            m_cuda_frame_size = 0;
+            m_table_size = 0;
+            m_table_geometry = letterbox_geometry();
+        }
+    }
 }
\ No newline at end of file
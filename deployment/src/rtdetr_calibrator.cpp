@@ -0,0 +1,62 @@
+#include "rtdetr_calibrator.h"
+
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+namespace seeta {
+
+    Int8Calibrator::Int8Calibrator(CalibrationStream& stream, const std::string& cache_file)
+        : m_stream(stream), m_cache_file(cache_file) {
+    }
+
+    Int8Calibrator::~Int8Calibrator() {
+        if (m_cuda_batch_mem)
+            cudaFree(m_cuda_batch_mem);
+    }
+
+    int32_t Int8Calibrator::getBatchSize() const noexcept {
+        return m_stream.batch_size();
+    }
+
+    bool Int8Calibrator::getBatch(void* bindings[], char const* names[], int32_t nbBindings) noexcept {
+        if (!m_stream.next(m_batch)) {
+            std::cout << "Calibration finished after " << m_batches_done << " batches." << std::endl;
+            return false;
+        }
+        if (m_cuda_batch_mem == nullptr) {
+            cudaMalloc(&m_cuda_batch_mem, m_stream.batch_elems() * sizeof(float));
+        }
+        cudaMemcpy(m_cuda_batch_mem, (void*)m_batch.data(), m_stream.batch_elems() * sizeof(float), cudaMemcpyHostToDevice);
+        // rtdetr has one input
+        bindings[0] = m_cuda_batch_mem;
+
+        m_batches_done++;
+        printf("Calibrating:%d/%d\r", m_batches_done, m_stream.batches_num());
+        fflush(stdout);
+        return true;
+    }
+
+    void const* Int8Calibrator::readCalibrationCache(size_t& length) noexcept {
+        m_cache.clear();
+        std::ifstream in(m_cache_file, std::ios::binary);
+        if (in.is_open()) {
+            m_cache.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        length = m_cache.size();
+        if (length > 0) {
+            std::cout << "Use calibration cache " << m_cache_file << ", calibration images are skipped." << std::endl;
+        }
+        return length > 0 ? m_cache.data() : nullptr;
+    }
+
+    void Int8Calibrator::writeCalibrationCache(void const* ptr, size_t length) noexcept {
+        std::ofstream out(m_cache_file, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "open " << m_cache_file << " failed." << std::endl;
+            return;
+        }
+        out.write((const char*)ptr, length);
+        std::cout << "Write calibration cache to " << m_cache_file << std::endl;
+    }
+}
@@ -0,0 +1,87 @@
+#include "rtdetr_kernels.h"
+
+#include <cuda_fp16.h>
+
+namespace seeta {
+
+    static __global__ void normalize_kernel(const uint8_t* hwc_data, int channels, int plane_size, float* chw_data) {
+        int index = blockIdx.x * blockDim.x + threadIdx.x;
+        if (index < plane_size) {
+            float rgb[3];
+            normalize_pixel(hwc_data, channels, index, rgb);
+            chw_data[index] = rgb[0];
+            chw_data[plane_size + index] = rgb[1];
+            chw_data[2 * plane_size + index] = rgb[2];
+        }
+    }
+
+    static __global__ void normalize_half_kernel(const uint8_t* hwc_data, int channels, int plane_size, 
+                                                uint16_t* chw_data) {
+        int index = blockIdx.x * blockDim.x + threadIdx.x;
+        if (index < plane_size) {
+            float rgb[3];
+            normalize_pixel(hwc_data, channels, index, rgb);
+            chw_data[index] = __half_as_ushort(__float2half_rn(rgb[0]));
+            chw_data[plane_size + index] = __half_as_ushort(__float2half_rn(rgb[1]));
+            chw_data[2 * plane_size + index] = __half_as_ushort(__float2half_rn(rgb[2]));
+        }
+    }
+
+    static __global__ void letterbox_kernel(const uint8_t* src, int src_step, letterbox_geometry geometry,
+                                            letterbox_tables tables, float* chw_data) {
+        int plane_size = geometry.dst_width * geometry.dst_height;
+        int index = blockIdx.x * blockDim.x + threadIdx.x;
+        if (index < plane_size) {
+            float rgb[3];
+            letterbox_pixel(src, src_step, geometry, tables, index % geometry.dst_width, index / geometry.dst_width, rgb);
+            chw_data[index] = rgb[0];
+            chw_data[plane_size + index] = rgb[1];
+            chw_data[2 * plane_size + index] = rgb[2];
+        }
+    }
+
+    static __global__ void letterbox_half_kernel(const uint8_t* src, int src_step, letterbox_geometry geometry,
+                                                letterbox_tables tables, uint16_t* chw_data) {
+        int plane_size = geometry.dst_width * geometry.dst_height;
+        int index = blockIdx.x * blockDim.x + threadIdx.x;
+        if (index < plane_size) {
+            float rgb[3];
+            letterbox_pixel(src, src_step, geometry, tables, index % geometry.dst_width, index / geometry.dst_width, rgb);
+            chw_data[index] = __half_as_ushort(__float2half_rn(rgb[0]));
+            chw_data[plane_size + index] = __half_as_ushort(__float2half_rn(rgb[1]));
+            chw_data[2 * plane_size + index] = __half_as_ushort(__float2half_rn(rgb[2]));
+        }
+    }
+
+    void normalize_gpu(const uint8_t* cuda_hwc_data, int width, int height, int channels, float* cuda_chw_data,
+                    cudaStream_t stream) {
+        int plane_size = width * height;
+        const int threads = 256;
+        int blocks = (plane_size + threads - 1) / threads;
+        normalize_kernel<<<blocks, threads, 0, stream>>>(cuda_hwc_data, channels, plane_size, cuda_chw_data);
+    }
+
+    void normalize_half_gpu(const uint8_t* cuda_hwc_data, int width, int height, int channels, uint16_t* cuda_chw_data,
+                    cudaStream_t stream) {
+        int plane_size = width * height;
+        const int threads = 256;
+        int blocks = (plane_size + threads - 1) / threads;
+        normalize_half_kernel<<<blocks, threads, 0, stream>>>(cuda_hwc_data, channels, plane_size, cuda_chw_data);
+    }
+
+    void letterbox_gpu(const uint8_t* cuda_src, int src_step, const letterbox_geometry& geometry,
+                    const letterbox_tables& cuda_tables, float* cuda_chw_data, cudaStream_t stream) {
+        int plane_size = geometry.dst_width * geometry.dst_height;
+        const int threads = 256;
+        int blocks = (plane_size + threads - 1) / threads;
+        letterbox_kernel<<<blocks, threads, 0, stream>>>(cuda_src, src_step, geometry, cuda_tables, cuda_chw_data);
+    }
+
+    void letterbox_half_gpu(const uint8_t* cuda_src, int src_step, const letterbox_geometry& geometry,
+                    const letterbox_tables& cuda_tables, uint16_t* cuda_chw_data, cudaStream_t stream) {
+        int plane_size = geometry.dst_width * geometry.dst_height;
+        const int threads = 256;
+        int blocks = (plane_size + threads - 1) / threads;
+        letterbox_half_kernel<<<blocks, threads, 0, stream>>>(cuda_src, src_step, geometry, cuda_tables, cuda_chw_data);
+    }
+}
@@ -10,10 +10,41 @@ std::ostream& operator<<(std::ostream& out, const Config& cfg)
 	
 	out << "Images path: " << cfg.parameter.image_path << std::endl;
 	out << "Save results to: " << cfg.parameter.save_path << std::endl;
+	out << "Gray input: " << cfg.parameter.gray_input << ", uint8 input: " << cfg.parameter.uint8_input
+		<< ", device preprocess: " << cfg.parameter.device_preprocess << std::endl;
 	out << "Detector thresh: " << cfg.parameter.detector_thresh << std::endl;
+	out << "NMS iou thresh: " << cfg.parameter.nms_iou_thresh << ", agnostic: " << cfg.parameter.agnostic_nms
+		<< ", max det: " << cfg.parameter.max_det << std::endl;
 	out << "Workers num:" << cfg.parameter.workers_num << std::endl;
+	out << "Devices: " << cfg.parameter.devices << std::endl;
 	// out << "Model input size: " << cfg.parameter.input_size << std::endl;
-	out << "Saver num: " << cfg.parameter.saver_num << std::endl;
+	out << "Saver num: " << cfg.parameter.saver_num << ", save binary: " << cfg.parameter.save_binary << std::endl;
+	out << "Tile size: " << cfg.tile.tile_size << ", overlap: " << cfg.tile.overlap
+		<< ", full frame: " << cfg.tile.full_frame << ", merge thresh: " << cfg.tile.merge_thresh << std::endl;
+	out << "Video detect interval: " << cfg.video.detect_interval << ", min track confidence: " 
+		<< cfg.video.min_track_confidence << ", eval recall: " << cfg.video.eval_recall << std::endl;
+	out << "Motion gate: " << cfg.motion.enable << ", changed ratio: " << cfg.motion.changed_ratio
+		<< ", max region ratio: " << cfg.motion.max_region_ratio << std::endl;
+	if (!cfg.trace.trace_file.empty())
+		out << "Trace to: " << cfg.trace.trace_file << ", buffer size: " << cfg.trace.buffer_size << std::endl;
+	if (cfg.metrics.port > 0 || cfg.metrics.json_interval > 0)
+		out << "Metrics port: " << cfg.metrics.port << ", json interval: " << cfg.metrics.json_interval 
+			<< "s, json file: " << cfg.metrics.json_file << std::endl;
+	out << "Result cache: " << cfg.cache.enable << ", capacity: " << cfg.cache.capacity 
+		<< ", cache file: " << cfg.cache.cache_file << std::endl;
+	out << "Server socket: " << cfg.server.socket_path << ", max batch: " << cfg.server.max_batch
+		<< ", max delay: " << cfg.server.max_delay_us << "us, max frame: " << cfg.server.max_frame_mb << "MB" << std::endl;
+	out << "Server models: " << cfg.server.models << ", router queue depth: " << cfg.server.router_queue_depth
+		<< ", router slo: " << cfg.server.router_slo_ms << "ms" << std::endl;
+	out << "Manifest: " << cfg.manifest.manifest_file << ", incremental: " << cfg.manifest.incremental
+		<< ", sync every: " << cfg.manifest.sync_every << std::endl;
+	out << "Ordered results: " << cfg.reorder.enable << ", capacity: " << cfg.reorder.capacity
+		<< ", timeout: " << cfg.reorder.timeout_ms << "ms" << std::endl;
+	out << "Realtime deadline: " << cfg.realtime.deadline_ms << "ms, policy: " << cfg.realtime.policy
+		<< ", stale action: " << cfg.realtime.stale_action << ", source priority: " << cfg.realtime.source_priority << std::endl;
+	out << "Frame ring: " << cfg.ring.frame_ring << ", result ring: " << cfg.ring.result_ring << ", slots: "
+		<< cfg.ring.slots << ", max frame: " << cfg.ring.max_width << "x" << cfg.ring.max_height << std::endl;
+	out << "Load arrival fps: " << cfg.loadgen.arrival_fps << ", report file: " << cfg.loadgen.report_file << std::endl;
 	out << std::endl;
 	return out;
 }
@@ -34,10 +65,78 @@ const Config ReadConfig(const std::string& ininame)
 	cfg.parameter.image_path = iniparser_getstring(ini, "parameter:IMAGE_PATH","null");
 	cfg.parameter.save_path = iniparser_getstring(ini, "parameter:SAVE_PATH", "null");
 
+	cfg.parameter.gray_input = iniparser_getboolean(ini, "parameter:GRAY_INPUT", 0);
+	cfg.parameter.uint8_input = iniparser_getboolean(ini, "parameter:UINT8_INPUT", 0);
+	cfg.parameter.device_preprocess = iniparser_getboolean(ini, "parameter:DEVICE_PREPROCESS", 0);
 	cfg.parameter.detector_thresh = iniparser_getdouble(ini, "parameter:DETECTOR_THRESH", 0.0);
+	cfg.parameter.nms_iou_thresh = iniparser_getdouble(ini, "parameter:NMS_IOU_THRESH", 0.0);
+	cfg.parameter.agnostic_nms = iniparser_getboolean(ini, "parameter:AGNOSTIC_NMS", 0);
+	cfg.parameter.max_det = iniparser_getint(ini, "parameter:MAX_DET", 0);
 	cfg.parameter.workers_num = iniparser_getint(ini, "parameter:WORKERS_NUM", 1);
+	cfg.parameter.devices = iniparser_getstring(ini, "parameter:DEVICES", "");
 	// cfg.parameter.input_size = iniparser_getint(ini, "parameter:INPUT_SIZE", 640);
 	cfg.parameter.saver_num = iniparser_getint(ini, "parameter:SAVER_NUM", 1);
+	cfg.parameter.save_binary = iniparser_getboolean(ini, "parameter:SAVE_BINARY", 0);
+
+	cfg.tile.tile_size = iniparser_getint(ini, "tile:TILE_SIZE", 0);
+	cfg.tile.overlap = iniparser_getint(ini, "tile:OVERLAP", 128);
+	cfg.tile.full_frame = iniparser_getboolean(ini, "tile:FULL_FRAME", 0);
+	cfg.tile.merge_thresh = iniparser_getdouble(ini, "tile:MERGE_THRESH", 0.6);
+
+	cfg.video.detect_interval = iniparser_getint(ini, "video:DETECT_INTERVAL", 3);
+	cfg.video.min_track_confidence = iniparser_getdouble(ini, "video:MIN_TRACK_CONFIDENCE", 0.3);
+	cfg.video.track_iou = iniparser_getdouble(ini, "video:TRACK_IOU", 0.3);
+	cfg.video.track_distance = iniparser_getdouble(ini, "video:TRACK_DISTANCE", 1.0);
+	cfg.video.max_misses = iniparser_getint(ini, "video:MAX_MISSES", 6);
+	cfg.video.confidence_decay = iniparser_getdouble(ini, "video:CONFIDENCE_DECAY", 0.9);
+	cfg.video.eval_recall = iniparser_getboolean(ini, "video:EVAL_RECALL", 0);
+
+	cfg.motion.enable = iniparser_getboolean(ini, "motion:ENABLE", 0);
+	cfg.motion.width = iniparser_getint(ini, "motion:WIDTH", 160);
+	cfg.motion.pixel_thresh = iniparser_getint(ini, "motion:PIXEL_THRESH", 12);
+	cfg.motion.changed_ratio = iniparser_getdouble(ini, "motion:CHANGED_RATIO", 0.001);
+	cfg.motion.max_region_ratio = iniparser_getdouble(ini, "motion:MAX_REGION_RATIO", 0.0);
+
+	cfg.trace.trace_file = iniparser_getstring(ini, "trace:TRACE_FILE", "");
+	cfg.trace.buffer_size = iniparser_getint(ini, "trace:BUFFER_SIZE", 65536);
+
+	cfg.metrics.port = iniparser_getint(ini, "metrics:PORT", 0);
+	cfg.metrics.json_interval = iniparser_getint(ini, "metrics:JSON_INTERVAL", 0);
+	cfg.metrics.json_file = iniparser_getstring(ini, "metrics:JSON_FILE", "");
+
+	cfg.cache.enable = iniparser_getboolean(ini, "cache:ENABLE", 0);
+	cfg.cache.capacity = iniparser_getint(ini, "cache:CAPACITY", 100000);
+	cfg.cache.cache_file = iniparser_getstring(ini, "cache:CACHE_FILE", "");
+
+	cfg.server.socket_path = iniparser_getstring(ini, "server:SOCKET_PATH", "/tmp/rtdetr.sock");
+	cfg.server.max_batch = iniparser_getint(ini, "server:MAX_BATCH", 0);
+	cfg.server.max_delay_us = iniparser_getint(ini, "server:MAX_DELAY_US", 2000);
+	cfg.server.max_frame_mb = iniparser_getint(ini, "server:MAX_FRAME_MB", 64);
+	cfg.server.models = iniparser_getstring(ini, "server:MODELS", "");
+	cfg.server.router_queue_depth = iniparser_getint(ini, "server:ROUTER_QUEUE_DEPTH", 32);
+	cfg.server.router_slo_ms = iniparser_getint(ini, "server:ROUTER_SLO_MS", 0);
+
+	cfg.manifest.manifest_file = iniparser_getstring(ini, "manifest:MANIFEST_FILE", "");
+	cfg.manifest.incremental = iniparser_getboolean(ini, "manifest:INCREMENTAL", 0);
+	cfg.manifest.sync_every = iniparser_getint(ini, "manifest:SYNC_EVERY", 1000);
+
+	cfg.reorder.enable = iniparser_getboolean(ini, "reorder:ENABLE", 0);
+	cfg.reorder.capacity = iniparser_getint(ini, "reorder:CAPACITY", 64);
+	cfg.reorder.timeout_ms = iniparser_getdouble(ini, "reorder:TIMEOUT_MS", 200.0);
+
+	cfg.realtime.deadline_ms = iniparser_getdouble(ini, "realtime:DEADLINE_MS", 0.0);
+	cfg.realtime.policy = iniparser_getstring(ini, "realtime:POLICY", "fifo");
+	cfg.realtime.stale_action = iniparser_getstring(ini, "realtime:STALE_ACTION", "drop");
+	cfg.realtime.source_priority = iniparser_getstring(ini, "realtime:SOURCE_PRIORITY", "");
+
+	cfg.ring.frame_ring = iniparser_getstring(ini, "ring:FRAME_RING", "/rtdetr_frames");
+	cfg.ring.result_ring = iniparser_getstring(ini, "ring:RESULT_RING", "/rtdetr_results");
+	cfg.ring.slots = iniparser_getint(ini, "ring:SLOTS", 4);
+	cfg.ring.max_width = iniparser_getint(ini, "ring:MAX_WIDTH", 1920);
+	cfg.ring.max_height = iniparser_getint(ini, "ring:MAX_HEIGHT", 1080);
+
+	cfg.loadgen.arrival_fps = iniparser_getdouble(ini, "loadgen:ARRIVAL_FPS", 0.0);
+	cfg.loadgen.report_file = iniparser_getstring(ini, "loadgen:REPORT_FILE", "");
 	iniparser_freedict(ini);
 
 	return cfg;
@@ -15,12 +15,159 @@ struct Config
 		std::string image_path;
 		std::string save_path;
 
+		// decode images as one channel, for gray datasets
+		bool gray_input;
+		// upload letterboxed uint8 images, normalized on the device
+		bool uint8_input;
+		// letterbox raw frames on the device, patterns that detect decoded frames (1, 2, 6, 7, 8, server)
+		bool device_preprocess;
 		float detector_thresh;
+		// nms after postprocess, disabled if nms_iou_thresh <= 0
+		float nms_iou_thresh;
+		bool agnostic_nms;
+		int max_det;
 		int workers_num;
+		// cuda devices the workers are spread over, e.g. "0,1", empty is the current device
+		std::string devices;
 		// int input_size;
 		int saver_num;
+		// pattern 3/4/5 save results as binary .bin instead of .txt, read by rtdetr_eval
+		bool save_binary;
 	} parameter;
 
+	struct
+	{
+		// tile width and height, 0 means model input size
+		int tile_size;
+		int overlap;
+		bool full_frame;
+		float merge_thresh;
+	} tile;
+
+	struct
+	{
+		// run the detector every detect_interval frames, tracker predicts the frames between
+		int detect_interval;
+		// detect earlier if any track confidence falls below
+		float min_track_confidence;
+		float track_iou;
+		float track_distance;
+		int max_misses;
+		float confidence_decay;
+		// also detect every frame to measure recall loss of skipped frames
+		bool eval_recall;
+	} video;
+
+	struct
+	{
+		// skip frames without changes since the last inferred frame
+		bool enable;
+		// frames are compared on a gray thumbnail of this width
+		int width;
+		int pixel_thresh;
+		float changed_ratio;
+		// infer the changed region only, if smaller than max_region_ratio of the frame
+		float max_region_ratio;
+	} motion;
+
+	struct
+	{
+		// chrome trace json output, tracing is disabled if empty
+		std::string trace_file;
+		// events kept per thread
+		int buffer_size;
+	} trace;
+
+	struct
+	{
+		// prometheus text on http://127.0.0.1:port/metrics, disabled if 0
+		int port;
+		// seconds between json log lines, disabled if 0
+		int json_interval;
+		// json lines go to stdout if empty
+		std::string json_file;
+	} metrics;
+
+	struct
+	{
+		// results of identical image files are reused, skipping decode and inference
+		bool enable;
+		// entries kept in memory, least recently used are evicted
+		int capacity;
+		// results persist between runs if not empty
+		std::string cache_file;
+	} cache;
+
+	struct
+	{
+		// unix domain socket of rtdetr_server
+		std::string socket_path;
+		// requests inferred together, 0 means the engine batch size
+		int max_batch;
+		// the oldest request waits at most max_delay_us for a fuller batch
+		int max_delay_us;
+		// largest request payload, raw frame or encoded file, larger ones close the connection
+		int max_frame_mb;
+		// engines of different input sizes, e.g. "a640.engine,b1024.engine", the router picks one per
+		// request. empty serves detector_model only
+		std::string models;
+		// a request degrades to a smaller engine when this many wait for the larger one, 0 disables
+		int router_queue_depth;
+		// or when the larger one is expected to take longer, 0 disables
+		int router_slo_ms;
+	} server;
+
+	struct
+	{
+		// completed images of pattern 3/4/5, empty disables resuming
+		std::string manifest_file;
+		// process new and modified images only, stats every image
+		bool incremental;
+		// fdatasync every n completed images, 0 leaves it to the os
+		int sync_every;
+	} manifest;
+
+	struct
+	{
+		// pattern 3/4/5 write results in frame order
+		bool enable;
+		// results held while waiting for a missing frame, more give up the missing frame
+		int capacity;
+		// longest wait for a missing frame before later results are written without it, 0 waits until capacity
+		float timeout_ms;
+	} reorder;
+
+	struct
+	{
+		// frames waiting longer are shed instead of inferred, 0 disables
+		float deadline_ms;
+		// fifo, newest or priority
+		std::string policy;
+		// drop, or reuse the newest results of the frame source
+		std::string stale_action;
+		// "source:priority,...", sources are directories under image_path
+		std::string source_priority;
+	} realtime;
+
+	struct
+	{
+		// posix shared memory names of the frame ring and the results ring
+		std::string frame_ring;
+		std::string result_ring;
+		int slots;
+		// largest frame a producer may write, sizes the frame slots
+		int max_width;
+		int max_height;
+	} ring;
+
+	struct
+	{
+		// pattern 1-5 take frame i at i / arrival_fps seconds, 0 as fast as they read
+		float arrival_fps;
+		// a json line of throughput, latency, cpu and memory per run is appended, empty disables
+		std::string report_file;
+	} loadgen;
+
 };
 
 std::ostream &operator<<(std::ostream &out, const Config &cfg);
@@ -0,0 +1,82 @@
+#ifndef OTL_DEADLINE_QUEUE_H_
+#define OTL_DEADLINE_QUEUE_H_
+
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <utility>
+
+namespace otl {
+    // which waiting frame is served next
+    enum shed_policy {
+        SHED_FIFO = 0,      // oldest first, the offline behaviour
+        SHED_NEWEST = 1,    // newest first, a backlog costs the old frames instead of all of them
+        SHED_PRIORITY = 2,  // highest source priority first, newest first within a priority
+    };
+
+    static shed_policy parse_shed_policy(const std::string& name) {
+        if (name == "newest") return SHED_NEWEST;
+        if (name == "priority") return SHED_PRIORITY;
+        return SHED_FIFO;
+    }
+
+    // frames with an arrival time and a deadline. frames past their deadline are never served,
+    // pop hands them back so the caller can drop or downgrade them. not thread safe, guarded
+    // by the queue mutex of the pipeline like the std::queue it replaces
+    template <typename T>
+    class DeadlineQueue {
+        public:
+        struct Item {
+            T value;
+            int64_t arrival_us;
+            int64_t deadline_us;    // 0 means no deadline
+            int priority;
+        };
+
+        void set_policy(shed_policy policy) { m_policy = policy; }
+
+        void push(const T& value, int64_t arrival_us, int64_t deadline_us, int priority) {
+            Item item = {value, arrival_us, deadline_us, priority};
+            m_items.push_back(item);
+        }
+
+        bool empty() const { return m_items.empty(); }
+        size_t size() const { return m_items.size(); }
+
+        // the next frame to serve at now_us. expired frames are appended to expired, oldest first.
+        // false if no frame is left to serve
+        bool pop(int64_t now_us, T& value, std::vector<T>& expired) {
+            for (typename std::deque<Item>::iterator it = m_items.begin(); it != m_items.end();) {
+                if (it->deadline_us > 0 && now_us > it->deadline_us) {
+                    expired.push_back(it->value);
+                    it = m_items.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (m_items.empty()) return false;
+
+            typename std::deque<Item>::iterator next = m_items.begin();
+            if (m_policy == SHED_NEWEST) {
+                next = m_items.end() - 1;
+            } else if (m_policy == SHED_PRIORITY) {
+                for (typename std::deque<Item>::iterator it = m_items.begin(); it != m_items.end(); ++it) {
+                    if (it->priority > next->priority ||
+                        (it->priority == next->priority && it->arrival_us >= next->arrival_us)) {
+                        next = it;
+                    }
+                }
+            }
+            value = next->value;
+            m_items.erase(next);
+            return true;
+        }
+
+        private:
+        shed_policy m_policy = SHED_FIFO;
+        std::deque<Item> m_items;
+    };
+}
+
+#endif // OTL_DEADLINE_QUEUE_H_
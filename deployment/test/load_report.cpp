@@ -0,0 +1,96 @@
+#include "load_report.h"
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace otl {
+    // CLOCK_MONOTONIC like seeta::monotonic_us, arrivals go into deadlines of the pipelines
+    static int64_t monotonic_us() {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return int64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+    }
+
+    // user and system time of the process
+    static int64_t cpu_us() {
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        return (int64_t(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000 +
+                usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+
+    void LoadReport::start(int pattern, int64_t frames, double arrival_fps, const std::string& report_file) {
+        m_pattern = pattern;
+        m_frames = frames;
+        m_arrival_fps = arrival_fps;
+        m_report_file = report_file;
+        m_latencies_us.clear();
+        if (enabled()) m_latencies_us.reserve(frames);
+        m_start_us = monotonic_us();
+        m_start_cpu_us = cpu_us();
+    }
+
+    int64_t LoadReport::arrive(int64_t frame) {
+        if (m_arrival_fps <= 0.0) return monotonic_us();
+        int64_t arrival_us = m_start_us + int64_t(frame * 1000000.0 / m_arrival_fps);
+        int64_t wait_us = arrival_us - monotonic_us();
+        if (wait_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+        return arrival_us;
+    }
+
+    void LoadReport::complete(int64_t arrival_us) {
+        if (!enabled()) return;
+        int64_t latency_us = monotonic_us() - arrival_us;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_latencies_us.push_back(latency_us);
+    }
+
+    std::string LoadReport::finish() {
+        double seconds = (monotonic_us() - m_start_us) / 1e6;
+        double cpu_seconds = (cpu_us() - m_start_cpu_us) / 1e6;
+        rusage usage;
+        int64_t peak_rss_kb = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+
+        std::vector<int64_t> latencies;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            latencies.swap(m_latencies_us);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto quantile_ms = [&latencies](double q) {
+            if (latencies.empty()) return 0.0;
+            size_t index = std::min(latencies.size() - 1, size_t(q * latencies.size()));
+            return latencies[index] / 1000.0;
+        };
+
+        // cpu_utilization is in cores, 1.0 is one core busy for the whole run
+        std::ostringstream out;
+        out << "{\"pattern\": " << m_pattern << ", \"frames\": " << m_frames << ", \"completed\": " << latencies.size()
+            << ", \"arrival_fps\": " << m_arrival_fps << ", \"seconds\": " << seconds
+            << ", \"throughput_fps\": " << (seconds > 0.0 ? latencies.size() / seconds : 0.0)
+            << ", \"latency_ms\": {\"p50\": " << quantile_ms(0.5) << ", \"p99\": " << quantile_ms(0.99)
+            << ", \"max\": " << (latencies.empty() ? 0.0 : latencies.back() / 1000.0) << "}"
+            << ", \"cpu_seconds\": " << cpu_seconds
+            << ", \"cpu_utilization\": " << (seconds > 0.0 ? cpu_seconds / seconds : 0.0)
+            << ", \"cpus\": " << std::thread::hardware_concurrency()
+            << ", \"peak_rss_mb\": " << peak_rss_kb / 1024.0 << "}";
+        std::string json = out.str();
+
+        if (enabled()) {
+            std::ofstream file(m_report_file, std::ios::app);
+            if (!file.is_open()) {
+                std::cerr << "open load report " << m_report_file << " failed." << std::endl;
+            } else {
+                file << json << std::endl;
+            }
+        }
+        return json;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef OTL_LOAD_REPORT_H_
+#define OTL_LOAD_REPORT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+namespace otl {
+    // open loop arrivals and frame latencies of one pipeline run, for rtdetr_loadgen.
+    // frame i arrives i / arrival_fps after start whether or not the pipeline kept up, so a
+    // backlog shows in the latency instead of slowing the arrivals. latency is arrival to saved
+    // results. finish appends one json line of the run to report_file
+    class LoadReport {
+        public:
+        // arrival_fps 0 takes frames as fast as the pipeline reads them
+        void start(int pattern, int64_t frames, double arrival_fps, const std::string& report_file);
+
+        // waits for the arrival of frame, returns its arrival time on the clock of seeta::monotonic_us
+        int64_t arrive(int64_t frame);
+
+        // results of a frame that arrived at arrival_us are saved. thread safe
+        void complete(int64_t arrival_us);
+
+        // false when no report is written, complete does nothing then
+        bool enabled() const { return !m_report_file.empty(); }
+
+        // run summary as json, appended to the report file
+        std::string finish();
+
+        private:
+        int m_pattern = 0;
+        int64_t m_frames = 0;
+        double m_arrival_fps = 0.0;
+        std::string m_report_file;
+        int64_t m_start_us = 0;
+        int64_t m_start_cpu_us = 0;
+        std::mutex m_mutex;
+        std::vector<int64_t> m_latencies_us;
+    };
+}
+
+#endif // OTL_LOAD_REPORT_H_
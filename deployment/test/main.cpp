@@ -5,6 +5,14 @@
 #include <fstream>
 #include "rtdetr_utils.h"
 #include "otl/thread/thread_pool.h"
+#include "rtdetr_tracker.h"
+#include "rtdetr_motion.h"
+#include "result_cache.h"
+#include "manifest.h"
+#include "rtdetr_shm_ring.h"
+#include "rtdetr_scheduler.h"
+#include "metrics.h"
+#include "load_report.h"
 
 struct RedetrDeleter
 {
@@ -15,6 +23,69 @@ struct RedetrDeleter
     }
 };
 
+// hash of the engine file, the thresholds and the input modes, results of another context differ:
+// gray input detects on other pixels, uint8 input and device preprocessing round differently
+static uint64_t results_context(const Config& config) {
+    struct {
+        float detector_thresh;
+        float nms_iou_thresh;
+        int agnostic_nms;
+        int max_det;
+        int gray_input;
+        int uint8_input;
+        int device_preprocess;
+    } params = {config.parameter.detector_thresh, config.parameter.nms_iou_thresh,
+                config.parameter.agnostic_nms, config.parameter.max_det, config.parameter.gray_input,
+                config.parameter.uint8_input, config.parameter.device_preprocess};
+    return otl::hash_bytes(&params, sizeof(params), otl::hash_file(config.model.detector_model));
+}
+
+// result cache of config, nullptr if disabled.
+// cached results are only valid for the same engine, thresholds and input modes, they are part of the key.
+static otl::ResultCache* create_result_cache(const Config& config) {
+    if (!config.cache.enable) return nullptr;
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t context = results_context(config);
+    otl::ResultCache* cache = new otl::ResultCache(config.cache.capacity, config.cache.cache_file, context);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::cout << "Init result cache spent " << duration.count() << "ms" << std::endl;
+    return cache;
+}
+
+// completion manifest of config, nullptr if disabled. a run of another engine, thresholds, input
+// modes, output format or save path does not resume from it
+static otl::CompletionManifest* create_manifest(const Config& config) {
+    if (config.manifest.manifest_file.empty()) return nullptr;
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t fingerprint = otl::hash_bytes(config.parameter.save_path.data(), config.parameter.save_path.size(),
+                                        results_context(config) + config.parameter.save_binary);
+    otl::CompletionManifest* manifest = new otl::CompletionManifest(config.manifest.manifest_file, fingerprint,
+                                                        config.manifest.incremental, config.manifest.sync_every);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::cout << "Init manifest spent " << duration.count() << "ms" << std::endl;
+    return manifest;
+}
+
+static void print_cache_stats(const otl::ResultCache* cache) {
+    if (cache == nullptr) return;
+    std::cout << "Result cache hits: " << cache->hits() << ", misses: " << cache->misses()
+            << ", hit rate: " << cache->hit_rate() * 100.0 << "%" << std::endl;
+}
+
+// arrivals and latencies of the run for rtdetr_loadgen, set up once the instances are loaded
+static otl::LoadReport loadReport;
+
+static void start_load_report(const Config& config, int pattern, int64_t frames) {
+    loadReport.start(pattern, frames, config.loadgen.arrival_fps, config.loadgen.report_file);
+}
+
+static void finish_load_report() {
+    std::string json = loadReport.finish();
+    if (loadReport.enabled()) std::cout << "Load report: " << json << std::endl;
+}
+
 int main_image_test(int argc, char** argv) {
     if (argc < 2) {
         printf("Usage: main image_path.\n");
@@ -31,13 +102,17 @@ int main_image_test(int argc, char** argv) {
     std::unique_ptr<seeta::Rtdetr, RedetrDeleter> rtdetr(
         new seeta::Rtdetr(config.model.detector_model.c_str(), 
         config.parameter.detector_thresh));
-    
+    rtdetr->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                    config.parameter.max_det);
+    rtdetr->set_uint8_input(config.parameter.uint8_input);
+    rtdetr->set_device_preprocess(config.parameter.device_preprocess);
+
     detect_result_group result_group;
     int test_count = 100;
     auto start = std::chrono::high_resolution_clock::now();
     for (int i = 0; i < test_count; ++i) 
     {
-        result_group = rtdetr->detect(image.data, image.cols, image.rows, false);
+        result_group = rtdetr->detect(image.data, image.cols, image.rows, image.channels(), false);
     }
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> duration = end - start;
@@ -82,49 +157,59 @@ int main_images_test(int argc, char** argv) {
     std::unique_ptr<seeta::Rtdetr, RedetrDeleter> rtdetr(
         new seeta::Rtdetr(config.model.detector_model.c_str(), 
         config.parameter.detector_thresh));
+    rtdetr->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                    config.parameter.max_det);
+    rtdetr->set_uint8_input(config.parameter.uint8_input);
+    rtdetr->set_device_preprocess(config.parameter.device_preprocess);
+    std::unique_ptr<otl::ResultCache> cache(create_result_cache(config));
+    std::vector<unsigned char> bytes;
+    std::vector<detect_result> cached;
+    // gray datasets are decoded and preprocessed as one channel
+    int imread_flags = config.parameter.gray_input ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
 
     int images_size = images.size();
+    start_load_report(config, 1, images_size);
     for(int i = 0; i < images_size; ++i) {
         if (i % 200 == 0) {
             printf("Process:%d/%d\r", i+1, images_size);
             fflush(stdout);
         }
 
+        int64_t arrival_us = loadReport.arrive(i);
         std::string image_path = images_path + seeta::FileSeparator() + images[i];
-        cv::Mat image;
-        {
-            // auto start = std::chrono::high_resolution_clock::now();
-            image = cv::imread(image_path);
-            // auto end = std::chrono::high_resolution_clock::now();
-            // std::chrono::duration<double, std::milli> duration = end - start;
-            // std::cout << "Reading image spent " << duration.count() << "ms" << std::endl; 
+        std::string file_name = seeta::getFileName(images[i]);
+        std::string base_name = seeta::getBaseName(file_name);
+        std::string saved_txt = saved_path + "/" + base_name + ".txt";
+
+        // the file bytes and the decoded image reuse their buffers across images
+        seeta::read_file(image_path, bytes);
+
+        // identical image file seen before, no decoding and inference
+        uint64_t cache_key = 0;
+        if (cache) {
+            cache_key = cache->key(bytes.data(), bytes.size());
+            if (cache->get(cache_key, cached)) {
+                seeta::write_results(saved_txt, cached);
+                loadReport.complete(arrival_us);
+                continue;
+            }
         }
 
-
         detect_result_group result_group;
-        result_group = rtdetr->detect(image.data, image.cols, image.rows, false);
+        result_group = rtdetr->detect_encoded(bytes.data(), bytes.size(), imread_flags, false);
+        if (result_group.size < 0) {
+            std::cerr << "read or detect " << image_path << " failed." << std::endl;
+            continue;
+        }
+        if (cache) {
+            cache->put(cache_key, std::vector<detect_result>(result_group.data, result_group.data + result_group.size));
+        }
 
         // write results to save path
         {
             // auto start = std::chrono::high_resolution_clock::now();
-
-            std::string file_name = seeta::getFileName(images[i]);
-            std::string base_name = seeta::getBaseName(file_name);
-            std::string saved_txt = saved_path + "/" + base_name + ".txt";
-            std::ofstream out(saved_txt);
-            for (int j = 0; j < result_group.size; ++j) {
-                float score = result_group.data[j].score;
-                bbox box = result_group.data[j].box;
-                int cls = result_group.data[j].cls;
-                if (j != 0) out << std::endl;
-                out << j + 1 << " " << cls << " " << score 
-                    << " " << box.x << " " << box.y
-                    << " " << box.x + box.width << " " << box.y
-                    << " " << box.x + box.width << " " << box.y + box.height
-                    << " " << box.x << " " << box.y + box.height
-                    << " " << box.x + box.width / 2.0 << " " << box.y + box.height / 2.0;
-            }
-            out.close();
+            seeta::write_results(saved_txt, result_group.data, result_group.size);
+            loadReport.complete(arrival_us);
             // auto end = std::chrono::high_resolution_clock::now();
             // std::chrono::duration<double, std::milli> duration = end - start;
             // std::cout << "Writing results to file spent " << duration.count() << "ms" << std::endl; 
@@ -135,6 +220,9 @@ int main_images_test(int argc, char** argv) {
     std::chrono::duration<double, std::milli> duration = end - start;
     std::cout << "Processing " << images_size << " images spent " 
             << duration.count() * 1.0 << "ms" << std::endl; 
+    std::cout << "Decode buffer allocations: " << rtdetr->decode_allocations() << std::endl;
+    print_cache_stats(cache.get());
+    finish_load_report();
 
     return 0;
 }
@@ -166,46 +254,52 @@ int main_images_multi_threads(int argc, char** argv) {
     // init using thread pool
     std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>> rtdetrs(config.parameter.workers_num);
     otl::ThreadPool thread_pool(config.parameter.workers_num);
+    // instances spread round robin over DEVICES
+    std::vector<int> devices = seeta::instance_devices(seeta::parse_devices(config.parameter.devices),
+                                                    config.parameter.workers_num);
     for (int i = 0; i < config.parameter.workers_num; i++) {
-        thread_pool.run([&rtdetrs, &config](int idx){
+        thread_pool.run([&rtdetrs, &config, &devices](int idx){
         rtdetrs[idx].reset(new seeta::Rtdetr(config.model.detector_model.c_str(), 
-                                        config.parameter.detector_thresh));
+                                        config.parameter.detector_thresh, devices[idx]));
+        rtdetrs[idx]->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                            config.parameter.max_det);
+        rtdetrs[idx]->set_uint8_input(config.parameter.uint8_input);
+        rtdetrs[idx]->set_device_preprocess(config.parameter.device_preprocess);
         });
     }
 
     thread_pool.join();
 
+    // file bytes per worker, the engine instance of the worker keeps the decoded image buffer
+    std::vector<std::vector<unsigned char> > worker_bytes(config.parameter.workers_num);
+    int imread_flags = config.parameter.gray_input ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
     int images_size = images.size();
+    start_load_report(config, 2, images_size);
     for(int i = 0; i < images_size; ++i) {
         if (i % 200 == 0) {
             printf("Process:%d/%d\r", i+1, images_size);
             fflush(stdout);
         }
-        thread_pool.run([&rtdetrs, &images, i, &images_path, &saved_path](int idx){
+        int64_t arrival_us = loadReport.arrive(i);
+        thread_pool.run([&rtdetrs, &worker_bytes, &images, i, arrival_us, &images_path, &saved_path,
+                        imread_flags](int idx){
             // std::cout << "worker idx: " << idx << std::endl;
             std::string image_path = images_path + seeta::FileSeparator() + images[i];
-            cv::Mat image = cv::imread(image_path);
+            std::vector<unsigned char>& bytes = worker_bytes[idx];
+            seeta::read_file(image_path, bytes);
             detect_result_group result_group;
-            result_group = rtdetrs[idx]->detect(image.data, image.cols, image.rows, false);
+            result_group = rtdetrs[idx]->detect_encoded(bytes.data(), bytes.size(), imread_flags);
+            if (result_group.size < 0) {
+                std::cerr << "read or detect " << image_path << " failed." << std::endl;
+                return;
+            }
 
             // write results to save path
             std::string file_name = seeta::getFileName(images[i]);
             std::string base_name = seeta::getBaseName(file_name);
             std::string saved_txt = saved_path + "/" + base_name + ".txt";
-            std::ofstream out(saved_txt);
-            for (int j = 0; j < result_group.size; ++j) {
-                float score = result_group.data[j].score;
-                bbox box = result_group.data[j].box;
-                int cls = result_group.data[j].cls;
-                if (j != 0) out << std::endl;
-                out << j + 1 << " " << cls << " " << score 
-                    << " " << box.x << " " << box.y
-                    << " " << box.x + box.width << " " << box.y
-                    << " " << box.x + box.width << " " << box.y + box.height
-                    << " " << box.x << " " << box.y + box.height
-                    << " " << box.x + box.width / 2.0 << " " << box.y + box.height / 2.0;
-            }
-            out.close();
+            seeta::write_results(saved_txt, result_group.data, result_group.size);
+            loadReport.complete(arrival_us);
         });
     }
     thread_pool.join();
@@ -214,50 +308,335 @@ int main_images_multi_threads(int argc, char** argv) {
     std::chrono::duration<double, std::milli> duration = end - start;
     std::cout << "Processing " << images_size << " images spent " 
             << duration.count() * 1.0 << "ms" << std::endl; 
+    finish_load_report();
 
     return 0;
 
 }
 
 #include <queue>
+#include <map>
+#include <sstream>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
 #include "vast_memory.h"
+#include "tracer.h"
+#include "deadline_queue.h"
+#include "reorder_buffer.h"
 
 struct InputInfo {
     std::shared_ptr<float> chw_data;
+    std::shared_ptr<unsigned char> hwc_data; // letterboxed pixels in place of chw_data with parameter:UINT8_INPUT
+    int channels;
+    int64_t frame_id;
+    uint64_t cache_key;
     std::string image;
     int origin_image_width;
     int origin_image_height;
+    int64_t arrival_us; // seeta::monotonic_us, see LoadReport::arrive
 };
 
 struct InputInfoV2 {
-    float* chw_data;
-    int data_idx;
+    float* chw_data; // from the float pool
+    unsigned char* hwc_data; // letterboxed pixels from the uint8 pool in place of chw_data with parameter:UINT8_INPUT
+    int data_idx; // group in the pool of the data
+    int channels;
+    int64_t frame_id;
+    uint64_t cache_key;
 
     std::string image;
     int origin_image_width;
     int origin_image_height;
+
+    // real-time mode, seeta::monotonic_us. frames past deadline_us are shed, 0 means no deadline
+    std::string source;
+    int64_t arrival_us;
+    int64_t deadline_us;
 };
 
 struct InferResult {
     std::vector<detect_result> results;
+    int64_t frame_id;
     std::string image; // for txt file
+    bool stale = false; // results of an earlier frame, see shed_frame
+    bool failed = false; // the engine pass failed, nothing is saved so a rerun detects the frame again
+    int64_t arrival_us = 0; // arrival of the frame, for the load report
 };
 
 static std::queue<InputInfo> inputQueue; // model input data buffer queue, including data and image file name
-static std::queue<InputInfoV2> inputQueueV2; // model input data buffer queue, including data and image file name
+static otl::DeadlineQueue<InputInfoV2> inputQueueV2; // model input data buffer queue, stale frames are shed
 static std::queue<InferResult> resultQueue; // results
 static std::mutex inputMutex, resultMutex;
 static std::condition_variable inputCondVar, resultCondVar;
 static std::atomic<bool> preprocess_done(false);
 static std::atomic<bool> infer_done(false);
+static otl::ResultCache* resultCache = nullptr; // optional, shared by all pipeline threads
+static bool saveBinary = false; // writers save .bin (seeta::write_results_binary) instead of .txt
+static otl::CompletionManifest* completionManifest = nullptr; // optional, images with saved results
+// pattern 3/4/5 with several DEVICES: jobs go to an instance of the least loaded device instead of
+// the instance of the worker thread
+static std::unique_ptr<seeta::DeviceScheduler> deviceScheduler;
+static std::vector<otl::Counter*> deviceFrames; // per instance, counter of its device
+
+// real-time mode of pattern 4/5, see [realtime] of config.ini
+static struct {
+    int64_t deadline_us = 0;        // 0 disables shedding
+    bool reuse_stale = false;       // stale frames get the newest results of their source instead of none
+    std::map<std::string, int> source_priority;
+} realtime;
+static std::mutex lastResultsMutex;
+static std::map<std::string, std::vector<detect_result> > lastResults; // newest results per source
+// pattern 3/4/5 write results in frame order if enabled, see [reorder] of config.ini. guarded by resultMutex
+static bool orderedResults = false;
+static otl::ReorderBuffer<InferResult> reorderBuffer;
+
+// live metrics of the pipeline patterns, exposed by otl::MetricsExporter
+static otl::Metrics& metrics = otl::Metrics::instance();
+static otl::Counter& framesIn = metrics.counter("rtdetr_frames_in_total", "", "frames taken by the preprocess thread");
+static otl::Counter& framesOut = metrics.counter("rtdetr_frames_out_total", "", "frames with results saved");
+static otl::Counter& decodeErrors = metrics.counter("rtdetr_decode_errors_total", "", "images that could not be read");
+static otl::Counter& engineErrors = metrics.counter("rtdetr_engine_errors_total", "", "failed engine executions");
+static otl::Histogram& imreadLatency = metrics.histogram("rtdetr_stage_latency_seconds", "stage=\"imread\"",
+                                                        "latency of a pipeline stage per frame");
+static otl::Histogram& preprocessLatency = metrics.histogram("rtdetr_stage_latency_seconds", "stage=\"preprocess\"", "");
+static otl::Histogram& detectLatency = metrics.histogram("rtdetr_stage_latency_seconds", "stage=\"detect\"", "");
+static otl::Histogram& writeLatency = metrics.histogram("rtdetr_stage_latency_seconds", "stage=\"write\"", "");
+static otl::Gauge& inputQueueDepth = metrics.gauge("rtdetr_queue_depth", "queue=\"input\"", "frames waiting in a queue");
+static otl::Gauge& resultQueueDepth = metrics.gauge("rtdetr_queue_depth", "queue=\"result\"", "");
+static otl::Gauge& vastMemoryFree = metrics.gauge("rtdetr_vast_memory_free_slots", "", "preallocated input buffers not in use");
+static otl::Gauge& busyWorkers = metrics.gauge("rtdetr_busy_workers", "", "workers running detect");
+static otl::Counter& framesDropped = metrics.counter("rtdetr_frames_shed_total", "action=\"drop\"",
+                                                    "frames past their deadline, not inferred");
+static otl::Counter& framesReused = metrics.counter("rtdetr_frames_shed_total", "action=\"reuse\"", "");
+static otl::Histogram& queueLatency = metrics.histogram("rtdetr_stage_latency_seconds", "stage=\"queue\"", "");
+static otl::Gauge& reorderHeld = metrics.gauge("rtdetr_queue_depth", "queue=\"reorder\"", "");
+static otl::Gauge& reorderDistance = metrics.gauge("rtdetr_reorder_max_distance", "",
+                                                "furthest a result arrived ahead of the next frame to write");
+static otl::Gauge& reorderBlocked = metrics.gauge("rtdetr_reorder_blocked_us", "",
+                                                "total time a missing frame held later results back");
+static otl::Gauge& reorderGivenUp = metrics.gauge("rtdetr_reorder_gaps_given_up", "",
+                                                "frames written past on timeout, their results come out of order");
+
+// results of an image to save path, named after the image
+static void save_results(const std::string& saved_path, const std::string& image, 
+                        const std::vector<detect_result>& results) {
+    std::string base_name = seeta::getBaseName(seeta::getFileName(image));
+    if (saveBinary) {
+        seeta::write_results_binary(saved_path + "/" + base_name + ".bin", results);
+    } else {
+        seeta::write_results(saved_path + "/" + base_name + ".txt", results);
+    }
+}
+
+// device scheduler of the instances if they are spread over more than one device
+static void setup_devices(const Config& config, const std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter> >& rtdetrs) {
+    deviceScheduler.reset();
+    deviceFrames.clear();
+    if (seeta::parse_devices(config.parameter.devices).size() < 2) return;
+    std::vector<int> devices;
+    for (const auto& rtdetr : rtdetrs) {
+        devices.push_back(rtdetr->device());
+        deviceFrames.push_back(&otl::Metrics::instance().counter("rtdetr_device_frames_total",
+                            "device=\"" + std::to_string(rtdetr->device()) + "\"", "frames inferred per cuda device"));
+    }
+    deviceScheduler.reset(new seeta::DeviceScheduler(devices));
+}
+
+// instance for a job on worker idx, the worker's own one without device scheduler
+static int acquire_instance(int idx) {
+    return deviceScheduler ? deviceScheduler->acquire() : idx;
+}
+
+static void release_instance(int instance, int64_t start_us) {
+    if (!deviceScheduler) return;
+    deviceScheduler->release(instance, seeta::monotonic_us() - start_us);
+    deviceFrames[instance]->inc();
+}
+
+static void print_device_stats() {
+    if (deviceScheduler) std::cout << deviceScheduler->report();
+}
+
+// source of a frame is its directory under IMAGE_PATH, e.g. one directory per camera
+static std::string frame_source(const std::string& image) {
+    size_t pos = image.find_last_of("/\\");
+    return pos == std::string::npos ? "" : image.substr(0, pos);
+}
+
+static void setup_realtime(const Config& config) {
+    realtime.deadline_us = int64_t(config.realtime.deadline_ms * 1000);
+    realtime.reuse_stale = config.realtime.stale_action == "reuse";
+    realtime.source_priority.clear();
+    // "cam0:2,cam1:1"
+    std::stringstream priorities(config.realtime.source_priority);
+    std::string item;
+    while (std::getline(priorities, item, ',')) {
+        size_t colon = item.rfind(':');
+        if (colon == std::string::npos) continue;
+        realtime.source_priority[item.substr(0, colon)] = atoi(item.c_str() + colon + 1);
+    }
+    inputQueueV2.set_policy(otl::parse_shed_policy(config.realtime.policy));
+    lastResults.clear();
+}
+
+static int source_priority(const std::string& source) {
+    auto priority = realtime.source_priority.find(source);
+    return priority == realtime.source_priority.end() ? 0 : priority->second;
+}
+
+static void setup_reorder(const Config& config) {
+    orderedResults = config.reorder.enable;
+    reorderBuffer.reset(config.reorder.capacity, int64_t(config.reorder.timeout_ms * 1000));
+}
+
+// frame_id will never have results (decode failure, dropped frame), the writer does not wait for it
+static void skip_result(int64_t frame_id) {
+    if (!orderedResults) return;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        reorderBuffer.skip(frame_id);
+    }
+    resultCondVar.notify_one();
+}
+
+// waits for results, in time for the reorder timeout
+template <typename Predicate>
+static void wait_results(std::unique_lock<std::mutex>& lock, Predicate ready) {
+    int64_t wait_us = orderedResults ? reorderBuffer.wait_us(seeta::monotonic_us()) : -1;
+    if (wait_us < 0) {
+        resultCondVar.wait(lock, ready);
+    } else {
+        resultCondVar.wait_for(lock, std::chrono::microseconds(wait_us), ready);
+    }
+}
+
+// moves the result queue to results, through the reorder buffer if enabled. called with resultMutex held,
+// finished releases everything still held
+static void take_results(std::vector<InferResult>& results, bool finished) {
+    results.reserve(resultQueue.size());
+    while  (!resultQueue.empty()) {
+        InferResult& infer_result = resultQueue.front();
+        otl::trace_async_end("resultQueue", infer_result.frame_id);
+        if (orderedResults) {
+            int64_t frame_id = infer_result.frame_id;
+            reorderBuffer.push(frame_id, std::move(infer_result));
+        } else {
+            results.emplace_back(std::move(infer_result));
+        }
+        resultQueue.pop();
+    }
+    resultQueueDepth.set(0);
+    if (!orderedResults) return;
+
+    int64_t now_us = seeta::monotonic_us();
+    if (finished) {
+        reorderBuffer.flush(now_us, results);
+    } else {
+        reorderBuffer.pop(now_us, results);
+    }
+    const otl::ReorderBuffer<InferResult>::Stats& stats = reorderBuffer.stats();
+    reorderHeld.set(reorderBuffer.size());
+    reorderDistance.set(stats.max_distance);
+    reorderBlocked.set(stats.blocked_us);
+    reorderGivenUp.set(stats.gaps_given_up);
+}
+
+static void print_reorder_stats() {
+    if (!orderedResults) return;
+    const otl::ReorderBuffer<InferResult>::Stats& stats = reorderBuffer.stats();
+    std::cout << "Reorder max distance: " << stats.max_distance << " frames, head-of-line blocking: "
+            << stats.blocked_us / 1000.0 << "ms (max " << stats.max_blocked_us / 1000.0 << "ms), timed out frames: "
+            << stats.gaps_given_up << ", late results: " << stats.late << std::endl;
+}
+
+// the input buffer of a frame goes back to its pool
+static void put_input_memory(const InputInfoV2& info, otl::vast_memory<float>& vast_memory,
+                            otl::vast_memory<unsigned char>& uint8_memory) {
+    if (info.hwc_data != nullptr) uint8_memory.put_memory_back(info.data_idx);
+    else vast_memory.put_memory_back(info.data_idx);
+    vastMemoryFree.add(1);
+}
+
+// a frame past its deadline: the buffer goes back, the frame is dropped or written with the
+// newest results of its source, so a backlog never delays the frames behind it
+static void shed_frame(const InputInfoV2& info, otl::vast_memory<float>& vast_memory,
+                    otl::vast_memory<unsigned char>& uint8_memory) {
+    OTL_TRACE_SCOPE("shed", info.frame_id);
+    put_input_memory(info, vast_memory, uint8_memory);
+    if (!realtime.reuse_stale) {
+        framesDropped.inc();
+        skip_result(info.frame_id);
+        return;
+    }
+    framesReused.inc();
+    InferResult infer_result;
+    infer_result.frame_id = info.frame_id;
+    infer_result.image = info.image;
+    infer_result.stale = true;
+    infer_result.arrival_us = info.arrival_us;
+    {
+        std::lock_guard<std::mutex> lock(lastResultsMutex);
+        auto last = lastResults.find(info.source);
+        if (last != lastResults.end()) infer_result.results = last->second;
+    }
+    {
+        std::lock_guard<std::mutex> resultLock(resultMutex);
+        resultQueue.push(std::move(infer_result));
+        resultQueueDepth.set(resultQueue.size());
+    }
+    otl::trace_async_begin("resultQueue", info.frame_id);
+    resultCondVar.notify_one();
+}
+
+static void print_shed_stats() {
+    if (realtime.deadline_us <= 0) return;
+    std::cout << "Frames past the deadline of " << realtime.deadline_us / 1000.0 << "ms: dropped "
+            << framesDropped.value() << ", reused results " << framesReused.value() << std::endl;
+}
+
+// reads the image of a frame. a result cache hit goes straight to the result queue and
+// false is returned, the frame skips decoding and inference.
+// bytes and decode_buffer belong to the calling thread and are reused, image is valid until the next call.
+static bool read_image(const std::string& image_path, const std::string& image_name, int64_t frame_id,
+                    int64_t arrival_us, int imread_flags, std::vector<unsigned char>& bytes,
+                    seeta::DecodeBuffer& decode_buffer, cv::Mat& image, uint64_t& cache_key) {
+    OTL_TRACE_SCOPE("imread", frame_id);
+    OTL_METRICS_TIMER(imreadLatency);
+    cache_key = 0;
+    seeta::read_file(image_path, bytes);
+    if (resultCache == nullptr) {
+        image = decode_buffer.decode(bytes.data(), bytes.size(), imread_flags);
+        return true;
+    }
+
+    cache_key = resultCache->key(bytes.data(), bytes.size());
+    InferResult infer_result;
+    if (resultCache->get(cache_key, infer_result.results)) {
+        infer_result.frame_id = frame_id;
+        infer_result.image = image_name;
+        infer_result.arrival_us = arrival_us;
+        {
+            std::lock_guard<std::mutex> resultLock(resultMutex);
+            resultQueue.push(std::move(infer_result));
+            resultQueueDepth.set(resultQueue.size());
+        }
+        otl::trace_async_begin("resultQueue", frame_id);
+        resultCondVar.notify_one();
+        return false;
+    }
+    image = decode_buffer.decode(bytes.data(), bytes.size(), imread_flags);
+    return true;
+}
 
 static void preprocess_func(const std::string& images_path, const std::vector<std::string>& images,
                             const Config& config, int input_size) {
+    otl::trace_thread_name("preprocess");
     int image_size = images.size();
+    int imread_flags = config.parameter.gray_input ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    std::vector<unsigned char> bytes;
+    seeta::DecodeBuffer decode_buffer;
 	for (int i = 0; i < image_size; ++i) {
         // progress bar
         if (i % 200 == 0) {
@@ -267,25 +646,57 @@ static void preprocess_func(const std::string& images_path, const std::vector<st
 
 		int queue_size = 0;
         std::string image_path = images_path + seeta::FileSeparator() + images[i];
-        cv::Mat image = cv::imread(image_path);
+        cv::Mat image;
+        uint64_t cache_key;
+        framesIn.inc();
+        int64_t arrival_us = loadReport.arrive(i);
+        if (!read_image(image_path, images[i], i, arrival_us, imread_flags, bytes, decode_buffer, image, cache_key)) {
+            continue;
+        }
+        if (image.empty()) {
+            std::cerr << "read " << image_path << " failed." << std::endl;
+            decodeErrors.inc();
+            skip_result(i);
+            continue;
+        }
 
         InputInfo input_info;
+        input_info.frame_id = i;
+        input_info.cache_key = cache_key;
         input_info.image = images[i];
         input_info.origin_image_width = image.cols;
         input_info.origin_image_height = image.rows;
-        input_info.chw_data.reset(new float[1 * 3 * input_size * input_size], std::default_delete<float[]>());
+        input_info.arrival_us = arrival_us;
+        input_info.channels = image.channels();
 
         float scale_x,scale_y;
         int padding_top, padding_bottom, padding_left, padding_right;
-        seeta::preprocess(image, input_size, input_size,
-                    scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
-                    true, (float*)input_info.chw_data.get());
+        {
+            OTL_TRACE_SCOPE("preprocess", i);
+            OTL_METRICS_TIMER(preprocessLatency);
+            if (config.parameter.uint8_input) {
+                // letterbox only, the engine normalizes on the device
+                input_info.hwc_data.reset(new unsigned char[3 * input_size * input_size],
+                                        std::default_delete<unsigned char[]>());
+                seeta::preprocess_uint8(image, input_size, input_size,
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, input_info.hwc_data.get());
+            } else {
+                input_info.chw_data.reset(new float[1 * 3 * input_size * input_size], std::default_delete<float[]>());
+                seeta::preprocess(image, input_size, input_size,
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, (float*)input_info.chw_data.get());
+            }
+        }
 		{
 			std::lock_guard<std::mutex> lock(inputMutex);
 			inputQueue.push(input_info);
             // std::cout << "input image:" << input_info.image << std::endl;
 			queue_size = inputQueue.size();
+            inputQueueDepth.set(queue_size);
 		}
+        otl::trace_async_begin("inputQueue", i);
+        otl::trace_counter("inputQueue_size", queue_size);
         // notify one
 		inputCondVar.notify_one();
 
@@ -298,14 +709,20 @@ static void preprocess_func(const std::string& images_path, const std::vector<st
 	}
     // done and notify all
     std::cout << "Preprocess_func finished!" << std::endl;
+    std::cout << "Decode buffer allocations: " << decode_buffer.allocations() << std::endl;
 	preprocess_done = true;
 	inputCondVar.notify_all();
 }
 
 
 static void preprocess_func_with_vast_memory(const std::string& images_path, const std::vector<std::string>& images,
-                            const Config& config, int input_size, otl::vast_memory<float>& vast_memory) {
+                            const Config& config, int input_size, otl::vast_memory<float>& vast_memory,
+                            otl::vast_memory<unsigned char>& uint8_memory) {
+    otl::trace_thread_name("preprocess");
     int image_size = images.size();
+    int imread_flags = config.parameter.gray_input ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    std::vector<unsigned char> bytes;
+    seeta::DecodeBuffer decode_buffer;
 	for (int i = 0; i < image_size; ++i) {
         // progress bar
         if (i % 200 == 0) {
@@ -315,50 +732,92 @@ static void preprocess_func_with_vast_memory(const std::string& images_path, con
 
 		int queue_size = 0;
         std::string image_path = images_path + seeta::FileSeparator() + images[i];
-        cv::Mat image = cv::imread(image_path);
+        cv::Mat image;
+        uint64_t cache_key;
+        framesIn.inc();
+        // the read time, or the scheduled arrival of a paced load
+        int64_t arrival_us = loadReport.arrive(i);
+        if (!read_image(image_path, images[i], i, arrival_us, imread_flags, bytes, decode_buffer, image, cache_key)) {
+            continue;
+        }
+        if (image.empty()) {
+            std::cerr << "read " << image_path << " failed." << std::endl;
+            decodeErrors.inc();
+            skip_result(i);
+            continue;
+        }
 
         InputInfoV2 input_info;
+        input_info.frame_id = i;
+        input_info.cache_key = cache_key;
         input_info.image = images[i];
         input_info.origin_image_width = image.cols;
         input_info.origin_image_height = image.rows;
+        input_info.source = frame_source(images[i]);
+        input_info.arrival_us = arrival_us;
+        input_info.deadline_us = realtime.deadline_us > 0 ? arrival_us + realtime.deadline_us : 0;
 
-        while(true) {
-            int idx;
-            float* memory = vast_memory.get_memory(idx);
-            // buffered data is not enough, just sleep a little
-            if (memory == nullptr) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-            else {
-                // got valid buffer from vast memory
-                input_info.chw_data = memory;
-                input_info.data_idx = idx;
-                break;
+        {
+            OTL_TRACE_SCOPE("wait_vast_memory", i);
+            while(true) {
+                int idx;
+                input_info.chw_data = nullptr;
+                input_info.hwc_data = nullptr;
+                if (config.parameter.uint8_input) input_info.hwc_data = uint8_memory.get_memory(idx);
+                else input_info.chw_data = vast_memory.get_memory(idx);
+                // buffered data is not enough, just sleep a little
+                if (input_info.chw_data == nullptr && input_info.hwc_data == nullptr) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                else {
+                    // got valid buffer from vast memory
+                    input_info.data_idx = idx;
+                    vastMemoryFree.add(-1);
+                    break;
+                }
             }
         }
 
         float scale_x,scale_y;
         int padding_top, padding_bottom, padding_left, padding_right;
-        seeta::preprocess(image, input_size, input_size,
-                    scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
-                    true, (float*)input_info.chw_data);
+        {
+            OTL_TRACE_SCOPE("preprocess", i);
+            OTL_METRICS_TIMER(preprocessLatency);
+            input_info.channels = image.channels();
+            if (config.parameter.uint8_input) {
+                // letterbox only, the engine normalizes on the device
+                seeta::preprocess_uint8(image, input_size, input_size,
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, input_info.hwc_data);
+            } else {
+                seeta::preprocess(image, input_size, input_size,
+                            scale_x, scale_y, padding_top, padding_bottom, padding_left, padding_right, 
+                            true, (float*)input_info.chw_data);
+            }
+        }
 		{
 			std::lock_guard<std::mutex> lock(inputMutex);
-			inputQueueV2.push(input_info);
+			inputQueueV2.push(input_info, input_info.arrival_us, input_info.deadline_us,
+                            source_priority(input_info.source));
             // std::cout << "input image:" << input_info.image << std::endl;
 			queue_size = inputQueueV2.size();
+            inputQueueDepth.set(queue_size);
 		}
+        otl::trace_async_begin("inputQueueV2", i);
+        otl::trace_counter("inputQueueV2_size", queue_size);
         // notify one
 		inputCondVar.notify_one();
 	}
     // done and notify all
     std::cout << "Preprocess_func finished!" << std::endl;
+    std::cout << "Decode buffer allocations: " << decode_buffer.allocations() << std::endl;
 	preprocess_done = true;
 	inputCondVar.notify_all();
 }
 
 static void infer_func(std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>>& rtdetrs,
         otl::ThreadPool& thread_pool, const Config& config) {
+    otl::trace_thread_name("infer");
 	while (true) {
         InputInfo info;
         info.chw_data = nullptr;
@@ -373,31 +832,65 @@ static void infer_func(std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>
             if (inputQueue.size() >= 1) {
                 info = inputQueue.front();
                 inputQueue.pop();
+                inputQueueDepth.set(inputQueue.size());
             }
         }
+        bool has_frame = info.chw_data != nullptr || info.hwc_data != nullptr;
+        if (has_frame) otl::trace_async_end("inputQueue", info.frame_id);
 
-		if (info.chw_data != nullptr) {
+		if (has_frame) {
             std::shared_ptr<float> chw_data = info.chw_data;
+            std::shared_ptr<unsigned char> hwc_data = info.hwc_data;
+            int channels = info.channels;
+            int64_t frame_id = info.frame_id;
+            uint64_t cache_key = info.cache_key;
             std::string image = info.image;
             // std::cout << "image: " << image << std::endl;
             int image_width = info.origin_image_width;
             int image_height = info.origin_image_height;
+            int64_t arrival_us = info.arrival_us;
              
-            // to multi threads inference
-            thread_pool.run([&rtdetrs, chw_data, image, image_width, image_height](int idx) {
+            // to multi threads inference, blocks in ThreadPool::load() until a worker is free
+            OTL_TRACE_SCOPE("wait_worker", frame_id);
+            thread_pool.run([&rtdetrs, chw_data, hwc_data, channels, frame_id, cache_key, image, image_width,
+                            image_height, arrival_us](int idx) {
                     // std::cout << "into run" << std::endl;
                     // std::cout << "index: " << idx << ", ptr: " << rtdetrs[idx].get() << std::endl;
+                    otl::trace_thread_name("worker");
                     InferResult infer_result;
-                    infer_result.results = rtdetrs[idx]->detect(chw_data.get(), image_width, image_height);
+                    {
+                        OTL_TRACE_SCOPE("detect", frame_id);
+                        OTL_METRICS_TIMER(detectLatency);
+                        busyWorkers.add(1);
+                        int instance = acquire_instance(idx);
+                        int64_t detect_us = seeta::monotonic_us();
+                        int64_t errors = rtdetrs[instance]->engine_errors();
+                        if (hwc_data) {
+                            infer_result.results = rtdetrs[instance]->detect_letterboxed(hwc_data.get(),
+                                                                    channels, image_width, image_height);
+                        } else {
+                            infer_result.results = rtdetrs[instance]->detect(chw_data.get(), image_width, image_height);
+                        }
+                        int64_t failures = rtdetrs[instance]->engine_errors() - errors;
+                        engineErrors.inc(failures);
+                        infer_result.failed = failures > 0;
+                        release_instance(instance, detect_us);
+                        busyWorkers.add(-1);
+                    }
+                    if (resultCache && !infer_result.failed) resultCache->put(cache_key, infer_result.results);
                     // std::cout << "after detect"<<std::endl;
+                    infer_result.frame_id = frame_id;
                     infer_result.image = image;
+                    infer_result.arrival_us = arrival_us;
                     
                     {
                         // put infer result to queue
                         std::lock_guard<std::mutex> resultLock(resultMutex);
                         // std::cout << "Got " << infer_result.image << " results into result queue." << std::endl;
                         resultQueue.push(std::move(infer_result));
+                        resultQueueDepth.set(resultQueue.size());
                     }
+                    otl::trace_async_begin("resultQueue", frame_id);
                     // notify one
                     resultCondVar.notify_one();
             });   
@@ -415,10 +908,14 @@ static void infer_func(std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>
 }
 
 static void infer_func_with_vast_memory(std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>>& rtdetrs,
-        otl::ThreadPool& thread_pool, const Config& config, otl::vast_memory<float>& vast_memory) {
+        otl::ThreadPool& thread_pool, const Config& config, otl::vast_memory<float>& vast_memory,
+        otl::vast_memory<unsigned char>& uint8_memory) {
+    otl::trace_thread_name("infer");
 	while (true) {
         InputInfoV2 info;
         info.chw_data = nullptr;
+        info.hwc_data = nullptr;
+        std::vector<InputInfoV2> expired;
         {
             std::unique_lock<std::mutex> lock(inputMutex);
             inputCondVar.wait(lock, [] { return !inputQueueV2.empty() || preprocess_done; });
@@ -428,39 +925,86 @@ static void infer_func_with_vast_memory(std::vector<std::unique_ptr<seeta::Rtdet
                 break;
 		    }
             if (inputQueueV2.size() >= 1) {
-                info = inputQueueV2.front();
-                inputQueueV2.pop();
+                // by the shed policy, frames past their deadline come back in expired
+                inputQueueV2.pop(seeta::monotonic_us(), info, expired);
+                inputQueueDepth.set(inputQueueV2.size());
             }
         }
+        for (const InputInfoV2& stale : expired) {
+            otl::trace_async_end("inputQueueV2", stale.frame_id);
+            shed_frame(stale, vast_memory, uint8_memory);
+        }
+        bool has_frame = info.chw_data != nullptr || info.hwc_data != nullptr;
+        if (has_frame) otl::trace_async_end("inputQueueV2", info.frame_id);
 
-		if (info.chw_data != nullptr) {
+		if (has_frame) {
             float* chw_data = info.chw_data;
-            int data_idx = info.data_idx;
+            unsigned char* hwc_data = info.hwc_data;
+            int channels = info.channels;
+            int64_t frame_id = info.frame_id;
+            uint64_t cache_key = info.cache_key;
 
             std::string image = info.image;
             // std::cout << "image: " << image << std::endl;
             int image_width = info.origin_image_width;
             int image_height = info.origin_image_height;
              
-            // to multi threads inference
-            thread_pool.run([&rtdetrs, chw_data, image, image_width, image_height, data_idx, &vast_memory](int idx) {
+            // to multi threads inference, blocks in ThreadPool::load() until a worker is free
+            OTL_TRACE_SCOPE("wait_worker", frame_id);
+            thread_pool.run([&rtdetrs, chw_data, hwc_data, channels, frame_id, cache_key, image, image_width,
+                            image_height, info, &vast_memory, &uint8_memory](int idx) {
                     // std::cout << "into run" << std::endl;
                     // std::cout << "index: " << idx << ", ptr: " << rtdetrs[idx].get() << std::endl;
+                    otl::trace_thread_name("worker");
+                    // may have waited for a free worker since it was popped
+                    int64_t start_us = seeta::monotonic_us();
+                    if (info.deadline_us > 0 && start_us > info.deadline_us) {
+                        shed_frame(info, vast_memory, uint8_memory);
+                        return;
+                    }
+                    queueLatency.observe(start_us - info.arrival_us);
                     InferResult infer_result;
-                    infer_result.results = rtdetrs[idx]->detect(chw_data, image_width, image_height);
+                    {
+                        OTL_TRACE_SCOPE("detect", frame_id);
+                        OTL_METRICS_TIMER(detectLatency);
+                        busyWorkers.add(1);
+                        int instance = acquire_instance(idx);
+                        int64_t detect_us = seeta::monotonic_us();
+                        int64_t errors = rtdetrs[instance]->engine_errors();
+                        if (hwc_data != nullptr) {
+                            infer_result.results = rtdetrs[instance]->detect_letterboxed(hwc_data,
+                                                                    channels, image_width, image_height);
+                        } else {
+                            infer_result.results = rtdetrs[instance]->detect(chw_data, image_width, image_height);
+                        }
+                        int64_t failures = rtdetrs[instance]->engine_errors() - errors;
+                        engineErrors.inc(failures);
+                        infer_result.failed = failures > 0;
+                        release_instance(instance, detect_us);
+                        busyWorkers.add(-1);
+                    }
+                    if (resultCache && !infer_result.failed) resultCache->put(cache_key, infer_result.results);
+                    if (realtime.reuse_stale && !infer_result.failed) {
+                        std::lock_guard<std::mutex> lock(lastResultsMutex);
+                        lastResults[info.source] = infer_result.results;
+                    }
                     // std::cout << "after detect"<<std::endl;
 
                     // put back memory to vast memory
-                    vast_memory.put_memory_back(data_idx);
+                    put_input_memory(info, vast_memory, uint8_memory);
 
+                    infer_result.frame_id = frame_id;
                     infer_result.image = image;
+                    infer_result.arrival_us = info.arrival_us;
                     
                     {
                         // put infer result to queue
                         std::lock_guard<std::mutex> resultLock(resultMutex);
                         // std::cout << "Got " << infer_result.image << " results into result queue." << std::endl;
                         resultQueue.push(std::move(infer_result));
+                        resultQueueDepth.set(resultQueue.size());
                     }
+                    otl::trace_async_begin("resultQueue", frame_id);
                     // notify one
                     resultCondVar.notify_one();
             });   
@@ -477,48 +1021,42 @@ static void infer_func_with_vast_memory(std::vector<std::unique_ptr<seeta::Rtdet
 	resultCondVar.notify_all();
 }
 
+// saves the results of a frame and accounts for it
+static void write_result(const std::string& saved_path, const InferResult& infer_result) {
+    OTL_TRACE_SCOPE("write", infer_result.frame_id);
+    OTL_METRICS_TIMER(writeLatency);
+    if (infer_result.failed) {
+        std::cerr << "detect " << infer_result.image << " failed, no results saved." << std::endl;
+    } else {
+        // write results to save path
+        save_results(saved_path, infer_result.image, infer_result.results);
+        if (completionManifest && !infer_result.stale) completionManifest->complete(infer_result.image);
+    }
+    loadReport.complete(infer_result.arrival_us);
+    framesOut.inc();
+}
+
 static void write_results_func(const std::string& saved_path) {
+    otl::trace_thread_name("writer");
 	while (true) {
         std::vector<InferResult> results;
 
         {
             std::unique_lock<std::mutex> lock(resultMutex);
-            resultCondVar.wait(lock, [] { return infer_done || !resultQueue.empty() || (preprocess_done && inputQueue.empty()); });
+            wait_results(lock, [] { return infer_done || !resultQueue.empty() || (preprocess_done && inputQueue.empty()); });
 
-            if (resultQueue.empty() && infer_done && inputQueue.empty() && preprocess_done) {
+            bool finished = resultQueue.empty() && infer_done && inputQueue.empty() && preprocess_done;
+            if (finished && (!orderedResults || reorderBuffer.empty())) {
                 std::cout << "Write results func finished!" << std::endl; 
                 break;
             }
             // collect all results
-            results.reserve(resultQueue.size());
-            while  (!resultQueue.empty()) {
-                InferResult& infer_result = resultQueue.front();
-                results.emplace_back(std::move(infer_result));
-                resultQueue.pop();
-            }
+            take_results(results, finished);
         }
         
         // std::cout << "result size: " << results.size() << std::endl;
         for (int i = 0; i < results.size(); ++i) {
-            InferResult& infer_result = results[i];
-            // write results to save path
-                std::string file_name = seeta::getFileName(infer_result.image);
-                std::string base_name = seeta::getBaseName(file_name);
-                std::string saved_txt = saved_path + "/" + base_name + ".txt";
-                std::ofstream out(saved_txt);
-                for (int j = 0; j < infer_result.results.size(); ++j) {
-                    float score = infer_result.results[j].score;
-                    bbox box = infer_result.results[j].box;
-                    int cls = infer_result.results[j].cls;
-                    if (j != 0) out << std::endl;
-                    out << j + 1 << " " << cls << " " << score 
-                        << " " << box.x << " " << box.y
-                        << " " << box.x + box.width << " " << box.y
-                        << " " << box.x + box.width << " " << box.y + box.height
-                        << " " << box.x << " " << box.y + box.height
-                        << " " << box.x + box.width / 2.0 << " " << box.y + box.height / 2.0;
-                }
-                out.close();
+            write_result(saved_path, results[i]);
         }
 
 	}
@@ -526,47 +1064,26 @@ static void write_results_func(const std::string& saved_path) {
 
 
 static void write_results_func_with_vast_memory(const std::string& saved_path) {
+    otl::trace_thread_name("writer");
 	while (true) {
         std::vector<InferResult> results;
 
         {
             std::unique_lock<std::mutex> lock(resultMutex);
-            resultCondVar.wait(lock, [] { return infer_done || !resultQueue.empty() || (preprocess_done && inputQueueV2.empty()); });
+            wait_results(lock, [] { return infer_done || !resultQueue.empty() || (preprocess_done && inputQueueV2.empty()); });
 
-            if (resultQueue.empty() && infer_done && inputQueueV2.empty() && preprocess_done) {
+            bool finished = resultQueue.empty() && infer_done && inputQueueV2.empty() && preprocess_done;
+            if (finished && (!orderedResults || reorderBuffer.empty())) {
                 std::cout << "Write results func finished!" << std::endl; 
                 break;
             }
             // collect all results
-            results.reserve(resultQueue.size());
-            while  (!resultQueue.empty()) {
-                InferResult& infer_result = resultQueue.front();
-                results.emplace_back(std::move(infer_result));
-                resultQueue.pop();
-            }
+            take_results(results, finished);
         }
         
         // std::cout << "result size: " << results.size() << std::endl;
         for (int i = 0; i < results.size(); ++i) {
-            InferResult& infer_result = results[i];
-            // write results to save path
-                std::string file_name = seeta::getFileName(infer_result.image);
-                std::string base_name = seeta::getBaseName(file_name);
-                std::string saved_txt = saved_path + "/" + base_name + ".txt";
-                std::ofstream out(saved_txt);
-                for (int j = 0; j < infer_result.results.size(); ++j) {
-                    float score = infer_result.results[j].score;
-                    bbox box = infer_result.results[j].box;
-                    int cls = infer_result.results[j].cls;
-                    if (j != 0) out << std::endl;
-                    out << j + 1 << " " << cls << " " << score 
-                        << " " << box.x << " " << box.y
-                        << " " << box.x + box.width << " " << box.y
-                        << " " << box.x + box.width << " " << box.y + box.height
-                        << " " << box.x << " " << box.y + box.height
-                        << " " << box.x + box.width / 2.0 << " " << box.y + box.height / 2.0;
-                }
-                out.close();
+            write_result(saved_path, results[i]);
         }
 
 	}
@@ -575,48 +1092,37 @@ static void write_results_func_with_vast_memory(const std::string& saved_path) {
 
 static void write_results_func_with_vast_memory_with_thread_pool(const std::string& saved_path, 
                                 otl::ThreadPool& thread_pool) {
+    otl::trace_thread_name("writer");
 	while (true) {
         std::vector<InferResult> results;
 
         {
             std::unique_lock<std::mutex> lock(resultMutex);
-            resultCondVar.wait(lock, [] { return infer_done || !resultQueue.empty() || (preprocess_done && inputQueueV2.empty()); });
+            wait_results(lock, [] { return infer_done || !resultQueue.empty() || (preprocess_done && inputQueueV2.empty()); });
 
-            if (resultQueue.empty() && infer_done && inputQueueV2.empty() && preprocess_done) {
+            bool finished = resultQueue.empty() && infer_done && inputQueueV2.empty() && preprocess_done;
+            if (finished && (!orderedResults || reorderBuffer.empty())) {
                 std::cout << "Write results func finished!" << std::endl; 
                 break;
             }
             // collect all results
-            results.reserve(resultQueue.size());
-            while  (!resultQueue.empty()) {
-                InferResult& infer_result = resultQueue.front();
-                results.emplace_back(std::move(infer_result));
-                resultQueue.pop();
-            }
+            take_results(results, finished);
         }
         
+        // the savers finish in any order, results in frame order are written here one after another
+        if (orderedResults) {
+            for (int i = 0; i < results.size(); ++i) {
+                write_result(saved_path, results[i]);
+            }
+            continue;
+        }
+
         // std::cout << "result size: " << results.size() << std::endl;
         for (int i = 0; i < results.size(); ++i) {
             InferResult& infer_result = results[i];
             thread_pool.run([&infer_result, &saved_path](int idx){
-                // write results to save path
-                std::string file_name = seeta::getFileName(infer_result.image);
-                std::string base_name = seeta::getBaseName(file_name);
-                std::string saved_txt = saved_path + "/" + base_name + ".txt";
-                std::ofstream out(saved_txt);
-                for (int j = 0; j < infer_result.results.size(); ++j) {
-                    float score = infer_result.results[j].score;
-                    bbox box = infer_result.results[j].box;
-                    int cls = infer_result.results[j].cls;
-                    if (j != 0) out << std::endl;
-                    out << j + 1 << " " << cls << " " << score 
-                        << " " << box.x << " " << box.y
-                        << " " << box.x + box.width << " " << box.y
-                        << " " << box.x + box.width << " " << box.y + box.height
-                        << " " << box.x << " " << box.y + box.height
-                        << " " << box.x + box.width / 2.0 << " " << box.y + box.height / 2.0;
-                }
-                out.close();
+                otl::trace_thread_name("saver");
+                write_result(saved_path, infer_result);
             });
             
         }
@@ -631,6 +1137,13 @@ int main_images_multi_threads_and_producer_consumer(int argc, char** argv) {
     Config config =  ReadConfig("config.ini");
     std::cout << config << std::endl;
 
+    // opt-in timeline tracing, dumped when the pipeline is finished
+    if (!config.trace.trace_file.empty()) {
+        otl::Tracer::instance().enable(config.trace.trace_file, config.trace.buffer_size);
+    }
+    // prometheus endpoint and json log lines while the pipeline runs
+    otl::MetricsExporter metrics_exporter(config.metrics.port, config.metrics.json_interval, config.metrics.json_file);
+
     std::string images_path = config.parameter.image_path;
     std::string saved_path = config.parameter.save_path;
     if (!seeta::directory_exists(saved_path)) {
@@ -640,6 +1153,14 @@ int main_images_multi_threads_and_producer_consumer(int argc, char** argv) {
 
     std::vector<std::string> images = seeta::FindFilesRecursively(images_path,-1);
     std::cout << "Found " << images.size() << " images." << std::endl;
+    // resume a crashed or stopped run, or only new and modified images
+    std::unique_ptr<otl::CompletionManifest> manifest(create_manifest(config));
+    completionManifest = manifest.get();
+    if (completionManifest) {
+        images = completionManifest->pending(images_path, images);
+        std::cout << "Skip " << completionManifest->skipped() << " completed images, " << images.size()
+                << " to process." << std::endl;
+    }
 
     std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>> rtdetrs(config.parameter.workers_num);
 
@@ -650,18 +1171,29 @@ int main_images_multi_threads_and_producer_consumer(int argc, char** argv) {
 
     // init using thread pool
     otl::ThreadPool thread_pool(config.parameter.workers_num);
+    // instances spread round robin over DEVICES
+    std::vector<int> devices = seeta::instance_devices(seeta::parse_devices(config.parameter.devices),
+                                                    config.parameter.workers_num);
     for (int i = 0; i < config.parameter.workers_num; i++) {
-        thread_pool.run([&rtdetrs, &config](int idx){
+        thread_pool.run([&rtdetrs, &config, &devices](int idx){
         rtdetrs[idx].reset(new seeta::Rtdetr(config.model.detector_model.c_str(), 
-                                        config.parameter.detector_thresh));
+                                        config.parameter.detector_thresh, devices[idx]));
+        rtdetrs[idx]->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                            config.parameter.max_det);
+        rtdetrs[idx]->set_uint8_input(config.parameter.uint8_input);
         });
     }
 
     thread_pool.join();
+    setup_devices(config, rtdetrs);
+    std::unique_ptr<otl::ResultCache> cache(create_result_cache(config));
+    resultCache = cache.get();
+    saveBinary = config.parameter.save_binary;
+    setup_reorder(config);
 
     int images_size = images.size();
     int input_size = rtdetrs[0]->input_dims().d[2];
-
+    start_load_report(config, 3, images_size);
 
     std::thread preprocess_thread(preprocess_func, std::ref(images_path), std::ref(images), 
                                 std::ref(config), input_size);
@@ -678,7 +1210,13 @@ int main_images_multi_threads_and_producer_consumer(int argc, char** argv) {
     std::chrono::duration<double, std::milli> duration = end - start;
     std::cout << "Processing " << images_size << " images spent " 
             << duration.count() * 1.0 << "ms" << std::endl;
+    print_cache_stats(resultCache);
+    print_device_stats();
+    print_reorder_stats();
+    finish_load_report();
+    resultCache = nullptr;
 
+    otl::Tracer::instance().dump();
     return 0;
 }
 
@@ -687,6 +1225,13 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory(int argc, c
     Config config =  ReadConfig("config.ini");
     std::cout << config << std::endl;
 
+    // opt-in timeline tracing, dumped when the pipeline is finished
+    if (!config.trace.trace_file.empty()) {
+        otl::Tracer::instance().enable(config.trace.trace_file, config.trace.buffer_size);
+    }
+    // prometheus endpoint and json log lines while the pipeline runs
+    otl::MetricsExporter metrics_exporter(config.metrics.port, config.metrics.json_interval, config.metrics.json_file);
+
     std::string images_path = config.parameter.image_path;
     std::string saved_path = config.parameter.save_path;
     if (!seeta::directory_exists(saved_path)) {
@@ -696,6 +1241,14 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory(int argc, c
 
     std::vector<std::string> images = seeta::FindFilesRecursively(images_path,-1);
     std::cout << "Found " << images.size() << " images." << std::endl;
+    // resume a crashed or stopped run, or only new and modified images
+    std::unique_ptr<otl::CompletionManifest> manifest(create_manifest(config));
+    completionManifest = manifest.get();
+    if (completionManifest) {
+        images = completionManifest->pending(images_path, images);
+        std::cout << "Skip " << completionManifest->skipped() << " completed images, " << images.size()
+                << " to process." << std::endl;
+    }
 
     std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>> rtdetrs(config.parameter.workers_num);
 
@@ -706,31 +1259,51 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory(int argc, c
 
     // init using thread pool
     otl::ThreadPool thread_pool(config.parameter.workers_num);
+    // instances spread round robin over DEVICES
+    std::vector<int> devices = seeta::instance_devices(seeta::parse_devices(config.parameter.devices),
+                                                    config.parameter.workers_num);
     for (int i = 0; i < config.parameter.workers_num; i++) {
-        thread_pool.run([&rtdetrs, &config](int idx){
+        thread_pool.run([&rtdetrs, &config, &devices](int idx){
         rtdetrs[idx].reset(new seeta::Rtdetr(config.model.detector_model.c_str(), 
-                                        config.parameter.detector_thresh));
+                                        config.parameter.detector_thresh, devices[idx]));
+        rtdetrs[idx]->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                            config.parameter.max_det);
+        rtdetrs[idx]->set_uint8_input(config.parameter.uint8_input);
         });
     }
 
     thread_pool.join();
+    setup_devices(config, rtdetrs);
+    std::unique_ptr<otl::ResultCache> cache(create_result_cache(config));
+    resultCache = cache.get();
+    saveBinary = config.parameter.save_binary;
+    setup_realtime(config);
+    setup_reorder(config);
 
     int images_size = images.size();
     int input_size = rtdetrs[0]->input_dims().d[2];
 
     // init vast memory
     auto start1 = std::chrono::high_resolution_clock::now();
-    otl::vast_memory<float> vast_memory(1 * 3 * input_size * input_size, config.parameter.workers_num * 4);
-    std::cout << "Vast memory groups:" << config.parameter.workers_num * 4 << ", group_size: " << 1 * 3 * input_size * input_size << std::endl;
+    // one pool per input type, the pool of the other type stays empty. the letterboxed pixels of
+    // parameter:UINT8_INPUT take a quarter of the memory
+    int groups = config.parameter.workers_num * 4;
+    bool uint8_input = config.parameter.uint8_input;
+    otl::vast_memory<float> vast_memory(uint8_input ? 0 : 1 * 3 * input_size * input_size, uint8_input ? 0 : groups);
+    otl::vast_memory<unsigned char> uint8_memory(uint8_input ? 3 * input_size * input_size : 0, uint8_input ? groups : 0);
+    vastMemoryFree.set(groups);
+    std::cout << "Vast memory groups:" << groups << ", group_size: " << 3 * input_size * input_size
+            << (uint8_input ? " bytes" : " floats") << std::endl;
     auto end1 = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> duration1 = end1 - start1;
     std::cout << "Init vast_memory spent " << duration1.count() << "ms" << std::endl; 
+    start_load_report(config, 4, images_size);
 
     std::thread preprocess_thread(preprocess_func_with_vast_memory, std::ref(images_path), std::ref(images), 
-                                std::ref(config), input_size, std::ref(vast_memory));
+                                std::ref(config), input_size, std::ref(vast_memory), std::ref(uint8_memory));
 
 	std::thread inference_thread(infer_func_with_vast_memory, std::ref(rtdetrs), std::ref(thread_pool),
-                            std::ref(config), std::ref(vast_memory));
+                            std::ref(config), std::ref(vast_memory), std::ref(uint8_memory));
 	std::thread write_thread(write_results_func_with_vast_memory, std::ref(saved_path));
 
 	preprocess_thread.join();
@@ -741,7 +1314,14 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory(int argc, c
     std::chrono::duration<double, std::milli> duration = end - start;
     std::cout << "Processing " << images_size << " images spent " 
             << duration.count() * 1.0 << "ms" << std::endl;
-
+    print_cache_stats(resultCache);
+    print_device_stats();
+    print_shed_stats();
+    print_reorder_stats();
+    finish_load_report();
+    resultCache = nullptr;
+
+    otl::Tracer::instance().dump();
     return 0;
 }
 
@@ -752,6 +1332,13 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory_with_multi_
     Config config =  ReadConfig("config.ini");
     std::cout << config << std::endl;
 
+    // opt-in timeline tracing, dumped when the pipeline is finished
+    if (!config.trace.trace_file.empty()) {
+        otl::Tracer::instance().enable(config.trace.trace_file, config.trace.buffer_size);
+    }
+    // prometheus endpoint and json log lines while the pipeline runs
+    otl::MetricsExporter metrics_exporter(config.metrics.port, config.metrics.json_interval, config.metrics.json_file);
+
     std::string images_path = config.parameter.image_path;
     std::string saved_path = config.parameter.save_path;
     if (!seeta::directory_exists(saved_path)) {
@@ -761,6 +1348,14 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory_with_multi_
 
     std::vector<std::string> images = seeta::FindFilesRecursively(images_path,-1);
     std::cout << "Found " << images.size() << " images." << std::endl;
+    // resume a crashed or stopped run, or only new and modified images
+    std::unique_ptr<otl::CompletionManifest> manifest(create_manifest(config));
+    completionManifest = manifest.get();
+    if (completionManifest) {
+        images = completionManifest->pending(images_path, images);
+        std::cout << "Skip " << completionManifest->skipped() << " completed images, " << images.size()
+                << " to process." << std::endl;
+    }
 
     std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>> rtdetrs(config.parameter.workers_num);
 
@@ -772,31 +1367,51 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory_with_multi_
     // init using thread pool
     otl::ThreadPool thread_pool(config.parameter.workers_num);
     otl::ThreadPool saver_thread_pool(config.parameter.saver_num);
+    // instances spread round robin over DEVICES
+    std::vector<int> devices = seeta::instance_devices(seeta::parse_devices(config.parameter.devices),
+                                                    config.parameter.workers_num);
     for (int i = 0; i < config.parameter.workers_num; i++) {
-        thread_pool.run([&rtdetrs, &config](int idx){
+        thread_pool.run([&rtdetrs, &config, &devices](int idx){
         rtdetrs[idx].reset(new seeta::Rtdetr(config.model.detector_model.c_str(), 
-                                        config.parameter.detector_thresh));
+                                        config.parameter.detector_thresh, devices[idx]));
+        rtdetrs[idx]->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                            config.parameter.max_det);
+        rtdetrs[idx]->set_uint8_input(config.parameter.uint8_input);
         });
     }
 
     thread_pool.join();
+    setup_devices(config, rtdetrs);
+    std::unique_ptr<otl::ResultCache> cache(create_result_cache(config));
+    resultCache = cache.get();
+    saveBinary = config.parameter.save_binary;
+    setup_realtime(config);
+    setup_reorder(config);
 
     int images_size = images.size();
     int input_size = rtdetrs[0]->input_dims().d[2];
 
     // init vast memory
     auto start1 = std::chrono::high_resolution_clock::now();
-    otl::vast_memory<float> vast_memory(1 * 3 * input_size * input_size, config.parameter.workers_num * 4);
-    std::cout << "Vast memory groups:" << config.parameter.workers_num * 4 << ", group_size: " << 1 * 3 * input_size * input_size << std::endl;
+    // one pool per input type, the pool of the other type stays empty. the letterboxed pixels of
+    // parameter:UINT8_INPUT take a quarter of the memory
+    int groups = config.parameter.workers_num * 4;
+    bool uint8_input = config.parameter.uint8_input;
+    otl::vast_memory<float> vast_memory(uint8_input ? 0 : 1 * 3 * input_size * input_size, uint8_input ? 0 : groups);
+    otl::vast_memory<unsigned char> uint8_memory(uint8_input ? 3 * input_size * input_size : 0, uint8_input ? groups : 0);
+    vastMemoryFree.set(groups);
+    std::cout << "Vast memory groups:" << groups << ", group_size: " << 3 * input_size * input_size
+            << (uint8_input ? " bytes" : " floats") << std::endl;
     auto end1 = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> duration1 = end1 - start1;
     std::cout << "Init vast_memory spent " << duration1.count() << "ms" << std::endl; 
+    start_load_report(config, 5, images_size);
 
     std::thread preprocess_thread(preprocess_func_with_vast_memory, std::ref(images_path), std::ref(images), 
-                                std::ref(config), input_size, std::ref(vast_memory));
+                                std::ref(config), input_size, std::ref(vast_memory), std::ref(uint8_memory));
 
 	std::thread inference_thread(infer_func_with_vast_memory, std::ref(rtdetrs), std::ref(thread_pool),
-                            std::ref(config), std::ref(vast_memory));
+                            std::ref(config), std::ref(vast_memory), std::ref(uint8_memory));
 	std::thread write_thread(write_results_func_with_vast_memory_with_thread_pool, 
                         std::ref(saved_path), std::ref(saver_thread_pool));
 
@@ -808,10 +1423,371 @@ int main_images_multi_threads_and_producer_consumer_with_vast_memory_with_multi_
     std::chrono::duration<double, std::milli> duration = end - start;
     std::cout << "Processing " << images_size << " images spent " 
             << duration.count() * 1.0 << "ms" << std::endl;
+    print_cache_stats(resultCache);
+    print_device_stats();
+    print_shed_stats();
+    print_reorder_stats();
+    finish_load_report();
+    resultCache = nullptr;
+
+    otl::Tracer::instance().dump();
+    return 0;
+}
+
+int main_images_tiled_multi_threads(int argc, char** argv) {
+    auto start = std::chrono::high_resolution_clock::now();
+    Config config =  ReadConfig("config.ini");
+    std::cout << config << std::endl;
+
+    std::string images_path = config.parameter.image_path;
+    std::string saved_path = config.parameter.save_path;
+    if (!seeta::directory_exists(saved_path)) {
+        std::cout << "Creating directory " << saved_path << std::endl;
+        seeta::create_directory(saved_path);
+    }
+
+    std::vector<std::string> images = seeta::FindFilesRecursively(images_path,-1);
+    std::cout << "Found " << images.size() << " images." << std::endl;
+
+    // init using thread pool
+    std::vector<std::unique_ptr<seeta::Rtdetr, RedetrDeleter>> rtdetrs(config.parameter.workers_num);
+    otl::ThreadPool thread_pool(config.parameter.workers_num);
+    // instances spread round robin over DEVICES
+    std::vector<int> devices = seeta::instance_devices(seeta::parse_devices(config.parameter.devices),
+                                                    config.parameter.workers_num);
+    for (int i = 0; i < config.parameter.workers_num; i++) {
+        thread_pool.run([&rtdetrs, &config, &devices](int idx){
+        rtdetrs[idx].reset(new seeta::Rtdetr(config.model.detector_model.c_str(), 
+                                        config.parameter.detector_thresh, devices[idx]));
+        rtdetrs[idx]->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                            config.parameter.max_det);
+        rtdetrs[idx]->set_device_preprocess(config.parameter.device_preprocess);
+        });
+    }
+
+    thread_pool.join();
+
+    tile_config tile;
+    tile.tile_size = config.tile.tile_size > 0 ? config.tile.tile_size : rtdetrs[0]->input_dims().d[3];
+    tile.overlap = config.tile.overlap;
+    tile.full_frame = config.tile.full_frame;
+    tile.merge_thresh = config.tile.merge_thresh;
+    if (!seeta::valid_tile_overlap(tile.tile_size, tile.overlap)) {
+        std::cerr << "tile:OVERLAP " << tile.overlap << " must be at least 0 and less than the tile size "
+                << tile.tile_size << "." << std::endl;
+        return -1;
+    }
+    std::cout << "Engine batch size: " << rtdetrs[0]->batch_size() << std::endl;
+
+    std::atomic<int64_t> tiles_num(0);
+    int imread_flags = config.parameter.gray_input ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    auto infer_start = std::chrono::high_resolution_clock::now();
+    int images_size = images.size();
+    for(int i = 0; i < images_size; ++i) {
+        if (i % 200 == 0) {
+            printf("Process:%d/%d\r", i+1, images_size);
+            fflush(stdout);
+        }
+        thread_pool.run([&rtdetrs, &images, i, &images_path, &saved_path, &tile, &tiles_num, imread_flags](int idx){
+            std::string image_path = images_path + seeta::FileSeparator() + images[i];
+            cv::Mat image = cv::imread(image_path, imread_flags);
+            if (image.empty()) {
+                std::cerr << "read " << image_path << " failed." << std::endl;
+                return;
+            }
+            detect_result_group result_group;
+            result_group = rtdetrs[idx]->detect_tiles(image.data, image.cols, image.rows, image.channels(), tile, false);
+            if (result_group.size < 0) {
+                std::cerr << "detect " << image_path << " failed." << std::endl;
+                return;
+            }
+
+            int tiles = seeta::make_tiles(image.cols, image.rows, tile.tile_size, tile.overlap).size();
+            tiles_num += (tile.full_frame && tiles > 1) ? tiles + 1 : tiles;
+
+            // write results to save path
+            std::string file_name = seeta::getFileName(images[i]);
+            std::string base_name = seeta::getBaseName(file_name);
+            std::string saved_txt = saved_path + "/" + base_name + ".txt";
+            seeta::write_results(saved_txt, result_group.data, result_group.size);
+        });
+    }
+    thread_pool.join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::chrono::duration<double> infer_duration = end - infer_start;
+    std::cout << "Processing " << images_size << " images spent " 
+            << duration.count() * 1.0 << "ms" << std::endl; 
+    std::cout << "Processing " << tiles_num << " tiles, " 
+            << tiles_num / infer_duration.count() << " tiles/s" << std::endl; 
 
     return 0;
 }
 
+// number of reference boxes found in results, same class and iou >= iou_thresh
+static int matched_boxes(const detect_result* reference, int reference_size, 
+                        const std::vector<detect_result>& results, float iou_thresh) {
+    std::vector<bool> used(results.size(), false);
+    int matched = 0;
+    for (int i = 0; i < reference_size; ++i) {
+        for (size_t j = 0; j < results.size(); ++j) {
+            if (!used[j] && results[j].cls == reference[i].cls && 
+                    seeta::box_iou(results[j].box, reference[i].box) >= iou_thresh) {
+                used[j] = true;
+                matched++;
+                break;
+            }
+        }
+    }
+    return matched;
+}
+
+// detect inside the changed region only, boxes outside it are kept from the previous detections
+static std::vector<detect_result> detect_changed_region(seeta::Rtdetr* rtdetr, const cv::Mat& image, 
+                        const cv::Rect& region, const std::vector<detect_result>& previous) {
+    std::vector<detect_result> results;
+    for (const detect_result& result : previous) {
+        cv::Rect box(int(result.box.x), int(result.box.y), int(result.box.width + 1), int(result.box.height + 1));
+        if ((box & region).empty()) results.push_back(result);
+    }
+
+    cv::Mat region_mat = image(region).clone();
+    detect_result_group result_group = rtdetr->detect(region_mat.data, region_mat.cols, region_mat.rows, false);
+    for (int i = 0; i < result_group.size; ++i) {
+        detect_result result = result_group.data[i];
+        result.box.x += region.x;
+        result.box.y += region.y;
+        results.push_back(result);
+    }
+    return results;
+}
+
+int main_video_tracking(int argc, char** argv) {
+    Config config =  ReadConfig("config.ini");
+    std::cout << config << std::endl;
+
+    std::string images_path = config.parameter.image_path;
+    std::string saved_path = config.parameter.save_path;
+    if (!seeta::directory_exists(saved_path)) {
+        std::cout << "Creating directory " << saved_path << std::endl;
+        seeta::create_directory(saved_path);
+    }
+
+    // frames of a recorded sequence, in name order
+    std::vector<std::string> frames = seeta::FindFilesRecursively(images_path,-1);
+    std::sort(frames.begin(), frames.end());
+    std::cout << "Found " << frames.size() << " frames." << std::endl;
+
+    std::unique_ptr<seeta::Rtdetr, RedetrDeleter> rtdetr(
+        new seeta::Rtdetr(config.model.detector_model.c_str(), 
+        config.parameter.detector_thresh));
+    rtdetr->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                    config.parameter.max_det);
+    rtdetr->set_uint8_input(config.parameter.uint8_input);
+    rtdetr->set_device_preprocess(config.parameter.device_preprocess);
+
+    seeta::tracker_config tracker_config;
+    tracker_config.match_iou = config.video.track_iou;
+    tracker_config.match_distance = config.video.track_distance;
+    tracker_config.max_misses = config.video.max_misses;
+    tracker_config.confidence_decay = config.video.confidence_decay;
+    seeta::IouTracker tracker(tracker_config);
+
+    seeta::motion_config motion_config;
+    motion_config.width = config.motion.width;
+    motion_config.pixel_thresh = config.motion.pixel_thresh;
+    motion_config.changed_ratio = config.motion.changed_ratio;
+    seeta::MotionGate motion_gate(motion_config);
+    int gated_frames = 0, region_frames = 0, full_frames = 0;
+    double full_detect_ms = 0.0;
+    std::vector<detect_result> last_results, last_detections;
+
+    int detect_interval = std::max(1, config.video.detect_interval);
+    int detected_frames = 0;
+    int64_t reference_boxes = 0, matched = 0, skipped_reference_boxes = 0, skipped_matched = 0;
+    double eval_ms = 0.0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int frames_size = frames.size();
+    int since_detect = detect_interval;
+    for (int i = 0; i < frames_size; ++i) {
+        if (i % 200 == 0) {
+            printf("Process:%d/%d\r", i+1, frames_size);
+            fflush(stdout);
+        }
+
+        std::string image_path = images_path + seeta::FileSeparator() + frames[i];
+        cv::Mat image = cv::imread(image_path);
+        if (image.empty()) {
+            std::cerr << "read " << image_path << " failed." << std::endl;
+            continue;
+        }
+
+        // static camera, frames not changed since the last inferred frame reuse its results
+        seeta::motion_result motion;
+        bool gated = false;
+        if (config.motion.enable) {
+            motion = motion_gate.check(image);
+            gated = !motion.changed;
+        }
+
+        // full detection every detect_interval frames, or when the tracker is losing objects
+        bool detect = !gated && (since_detect >= detect_interval || 
+                        tracker.confidence() < config.video.min_track_confidence);
+        std::vector<detect_result> results;
+        if (gated) {
+            results = last_results;
+            gated_frames++;
+        } else if (detect) {
+            std::vector<detect_result> detections;
+            bool region_only = config.motion.enable && detected_frames > 0 && !motion.region.empty() &&
+                    motion.region.area() < config.motion.max_region_ratio * image.cols * image.rows;
+            if (region_only) {
+                detections = detect_changed_region(rtdetr.get(), image, motion.region, last_detections);
+                region_frames++;
+            } else {
+                auto detect_start = std::chrono::high_resolution_clock::now();
+                detect_result_group result_group = rtdetr->detect(image.data, image.cols, image.rows, false);
+                // size -1 for a failed engine pass, the tracker only predicts then
+                if (result_group.size > 0) detections.assign(result_group.data, result_group.data + result_group.size);
+                auto detect_end = std::chrono::high_resolution_clock::now();
+                full_detect_ms += std::chrono::duration<double, std::milli>(detect_end - detect_start).count();
+                full_frames++;
+            }
+            results = tracker.update(detections.data(), detections.size());
+            last_detections = results;
+            motion_gate.accept();
+            detected_frames++;
+            since_detect = 1;
+        } else {
+            results = tracker.predict();
+            since_detect++;
+        }
+        last_results = results;
+
+        // recall of the tracked output against per-frame detection
+        if (config.video.eval_recall) {
+            auto eval_start = std::chrono::high_resolution_clock::now();
+            detect_result_group reference = rtdetr->detect(image.data, image.cols, image.rows, false);
+            reference.size = std::max(0, reference.size);
+            int frame_matched = matched_boxes(reference.data, reference.size, results, 0.5f);
+            reference_boxes += reference.size;
+            matched += frame_matched;
+            if (!detect) {
+                skipped_reference_boxes += reference.size;
+                skipped_matched += frame_matched;
+            }
+            auto eval_end = std::chrono::high_resolution_clock::now();
+            eval_ms += std::chrono::duration<double, std::milli>(eval_end - eval_start).count();
+        }
+
+        // write results with track ids to save path
+        std::string file_name = seeta::getFileName(frames[i]);
+        std::string base_name = seeta::getBaseName(file_name);
+        std::string saved_txt = saved_path + "/" + base_name + ".txt";
+        seeta::write_results(saved_txt, results, true);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    // evaluation passes are not part of the video mode cost
+    double spent_ms = duration.count() - eval_ms;
+    std::cout << "Processing " << frames_size << " frames spent " << spent_ms << "ms, detected "
+            << detected_frames << " frames, effective fps: " << frames_size * 1000.0 / spent_ms << std::endl;
+    if (config.motion.enable) {
+        // gated frames would have paid a full detection each
+        double saved_ms = full_frames > 0 ? gated_frames * full_detect_ms / full_frames : 0.0;
+        std::cout << "Motion gate skipped " << gated_frames << " frames, skip ratio: " 
+                << (frames_size > 0 ? gated_frames * 1.0 / frames_size : 0.0)
+                << ", region only frames: " << region_frames 
+                << ", saved inference time: " << saved_ms << "ms" << std::endl;
+    }
+    if (config.video.eval_recall) {
+        std::cout << "Recall against per-frame detection: " 
+                << (reference_boxes > 0 ? matched * 1.0 / reference_boxes : 1.0)
+                << ", on skipped frames: " 
+                << (skipped_reference_boxes > 0 ? skipped_matched * 1.0 / skipped_reference_boxes : 1.0)
+                << std::endl;
+    }
+
+    return 0;
+}
+
+// frames are detected in place in the shared memory slots written by a capture process
+// (tools/ring_producer.cpp), the detections are written to the results ring.
+int main_shared_memory_frames(int argc, char** argv) {
+    Config config =  ReadConfig("config.ini");
+    std::cout << config << std::endl;
+
+    std::unique_ptr<seeta::Rtdetr, RedetrDeleter> rtdetr(
+        new seeta::Rtdetr(config.model.detector_model.c_str(), 
+        config.parameter.detector_thresh));
+    rtdetr->set_nms(config.parameter.nms_iou_thresh, config.parameter.agnostic_nms, 
+                    config.parameter.max_det);
+    rtdetr->set_uint8_input(config.parameter.uint8_input);
+    rtdetr->set_device_preprocess(config.parameter.device_preprocess);
+
+    int max_det = config.parameter.max_det > 0 ? config.parameter.max_det : 300;
+    std::unique_ptr<seeta::ShmRing> frames(seeta::ShmRing::create(config.ring.frame_ring, config.ring.slots,
+            size_t(config.ring.max_width) * config.ring.max_height * 3));
+    std::unique_ptr<seeta::ShmRing> results(seeta::ShmRing::create(config.ring.result_ring, config.ring.slots * 2,
+            max_det * sizeof(detect_result)));
+    if (!frames || !results) {
+        return -1;
+    }
+    std::cout << "Waiting for frames on " << config.ring.frame_ring << std::endl;
+
+    int frames_num = 0, dropped_results = 0;
+    double detect_ms = 0.0;
+    int64_t latency_us = 0;
+    seeta::ring_slot* frame;
+    while ((frame = frames->begin_read(-1)) != nullptr) {
+        if (frame->width <= 0 || frame->height <= 0 || (frame->channels != 1 && frame->channels != 3) ||
+            size_t(frame->width) * frame->height * frame->channels > frames->slot_bytes()) {
+            std::cerr << "bad frame " << frame->frame_id << " of " << frame->width << "x" << frame->height << std::endl;
+            frames->end_read();
+            continue;
+        }
+        auto detect_start = std::chrono::high_resolution_clock::now();
+        detect_result_group result_group = rtdetr->detect(frame->data, frame->width, frame->height, 
+                                                        frame->channels, false);
+        auto detect_end = std::chrono::high_resolution_clock::now();
+        detect_ms += std::chrono::duration<double, std::milli>(detect_end - detect_start).count();
+
+        // the producer may be slow to take results, frames are not held back for long
+        seeta::ring_slot* result = results->begin_write(1000);
+        if (result != nullptr) {
+            // a failed engine pass gives size -1, the frame is answered without boxes
+            int count = std::max(0, std::min(result_group.size, max_det));
+            result->frame_id = frame->frame_id;
+            result->timestamp_us = frame->timestamp_us;
+            result->width = frame->width;
+            result->height = frame->height;
+            result->channels = frame->channels;
+            result->count = count;
+            memcpy(result->data, result_group.data, count * sizeof(detect_result));
+            results->end_write();
+        } else {
+            dropped_results++;
+        }
+        latency_us += seeta::monotonic_us() - frame->timestamp_us;
+        frames->end_read();
+
+        if (++frames_num % 200 == 0) {
+            printf("Process:%d\r", frames_num);
+            fflush(stdout);
+        }
+    }
+    results->close_writer();
+
+    std::cout << "Processed " << frames_num << " frames, mean detect " 
+            << (frames_num > 0 ? detect_ms / frames_num : 0.0) << "ms, mean frame latency "
+            << (frames_num > 0 ? latency_us / 1000.0 / frames_num : 0.0) << "ms, dropped results: "
+            << dropped_results << std::endl;
+    return 0;
+}
+
 int main(int argc, char** argv) {
     // return main_test(argc, argv);
 
@@ -826,6 +1802,12 @@ int main(int argc, char** argv) {
         std::cout << "pattern_code == 4: pattern_code==3 with preallocated memories \
                     to [preprocess image]." << std::endl;
         std::cout << "pattern_code == 5: pattern_code==4 with thread pool to [save results]." << std::endl;
+        std::cout << "pattern_code == 6: pattern_code==2 with overlapped tiles batched \
+                    to [infer high resolution images]." << std::endl;
+        std::cout << "pattern_code == 7: Video frames, [infer every N frames] and \
+                    [track objects between them]." << std::endl;
+        std::cout << "pattern_code == 8: Frames of a capture process in shared memory, \
+                    [infer frames in place] and [return results]." << std::endl;
         return 0;
     }
     int pattern_code = atoi(argv[1]);
@@ -865,5 +1847,26 @@ int main(int argc, char** argv) {
         return main_images_multi_threads_and_producer_consumer_with_vast_memory_with_multi_saver(argc, argv);
     }
 
+    if (pattern_code == 6) {
+        std::cout << std::endl;
+        std::cout << "pattern_code == 6: pattern_code==2 with overlapped tiles batched \
+                    to [infer high resolution images]." << std::endl;
+        return main_images_tiled_multi_threads(argc, argv);
+    }
+
+    if (pattern_code == 7) {
+        std::cout << std::endl;
+        std::cout << "pattern_code == 7: Video frames, [infer every N frames] and \
+                    [track objects between them]." << std::endl;
+        return main_video_tracking(argc, argv);
+    }
+
+    if (pattern_code == 8) {
+        std::cout << std::endl;
+        std::cout << "pattern_code == 8: Frames of a capture process in shared memory, \
+                    [infer frames in place] and [return results]." << std::endl;
+        return main_shared_memory_frames(argc, argv);
+    }
+
     return main_image_test(argc, argv);
 }
\ No newline at end of file
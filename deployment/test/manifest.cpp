@@ -0,0 +1,144 @@
+#include "manifest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace otl {
+    static const char kManifestHeader[] = "rtdetr-manifest v1 ";
+
+    FileStamp stamp_file(const std::string& path) {
+        FileStamp stamp;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return stamp;
+        stamp.size = st.st_size;
+        stamp.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return stamp;
+    }
+
+    CompletionManifest::CompletionManifest(const std::string& file, uint64_t fingerprint, bool incremental,
+                                        int sync_every)
+        : m_file(file), m_fingerprint(fingerprint), m_incremental(incremental), m_sync_every(sync_every) {
+        load();
+    }
+
+    CompletionManifest::~CompletionManifest() {
+        if (m_fd < 0) return;
+        fdatasync(m_fd);
+        close(m_fd);
+    }
+
+    // line layout: "size mtime_ns image\n", the image last so it may hold spaces
+    void CompletionManifest::load() {
+        std::ifstream in(m_file, std::ios::binary);
+        std::string line;
+        char header[64];
+        snprintf(header, sizeof(header), "%s%016" PRIx64, kManifestHeader, m_fingerprint);
+        if (!in.is_open() || !std::getline(in, line) || line != header) {
+            if (in.is_open()) {
+                std::cout << "Manifest " << m_file << " is of another engine or config, start over" << std::endl;
+            }
+            in.close();
+            restart();
+            return;
+        }
+
+        // a crash while appending leaves the last line without newline, it is cut off
+        off_t complete_size = line.size() + 1;
+        bool torn = false;
+        while (std::getline(in, line)) {
+            if (in.eof()) {
+                torn = true;
+                break;
+            }
+            complete_size += line.size() + 1;
+            std::istringstream fields(line);
+            FileStamp stamp;
+            if (!(fields >> stamp.size >> stamp.mtime_ns) || fields.get() != ' ') continue;
+            std::string image;
+            std::getline(fields, image);
+            if (!image.empty()) m_done[image] = stamp;
+        }
+        in.close();
+
+        m_fd = open(m_file.c_str(), O_WRONLY | O_APPEND);
+        if (m_fd < 0 || (torn && ftruncate(m_fd, complete_size) != 0)) {
+            std::cerr << "open manifest " << m_file << " failed: " << strerror(errno) << std::endl;
+            if (m_fd >= 0) close(m_fd);
+            m_fd = -1;
+            return;
+        }
+        std::cout << "Load " << m_done.size() << " completed images from manifest " << m_file << std::endl;
+    }
+
+    void CompletionManifest::restart() {
+        m_done.clear();
+        m_fd = open(m_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (m_fd < 0) {
+            std::cerr << "open manifest " << m_file << " failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        char header[64];
+        int size = snprintf(header, sizeof(header), "%s%016" PRIx64 "\n", kManifestHeader, m_fingerprint);
+        if (write(m_fd, header, size) != size || fdatasync(m_fd) != 0) {
+            std::cerr << "write manifest " << m_file << " failed: " << strerror(errno) << std::endl;
+        }
+    }
+
+    std::vector<std::string> CompletionManifest::pending(const std::string& images_path,
+                                                        const std::vector<std::string>& images) {
+        std::vector<std::string> todo;
+        todo.reserve(images.size());
+        m_skipped = 0;
+        for (const std::string& image : images) {
+            auto done = m_done.find(image);
+            if (!m_incremental) {
+                if (done != m_done.end()) {
+                    m_skipped++;
+                } else {
+                    todo.push_back(image);
+                }
+                continue;
+            }
+            // records of non-incremental runs have no stamp, they can not be trusted here
+            FileStamp stamp = stamp_file(images_path + "/" + image);
+            if (done != m_done.end() && done->second.known() && done->second == stamp) {
+                m_skipped++;
+                continue;
+            }
+            m_stamps[image] = stamp;
+            todo.push_back(image);
+        }
+        return todo;
+    }
+
+    void CompletionManifest::complete(const std::string& image) {
+        // a record is a single line
+        if (m_fd < 0 || image.find('\n') != std::string::npos) return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FileStamp stamp;
+        if (m_incremental) {
+            auto found = m_stamps.find(image);
+            if (found != m_stamps.end()) stamp = found->second;
+        }
+        char prefix[48];
+        snprintf(prefix, sizeof(prefix), "%" PRId64 " %" PRId64 " ", stamp.size, stamp.mtime_ns);
+        std::string record = prefix + image + "\n";
+        // O_APPEND, one write per record never interleaves with another record
+        if (write(m_fd, record.data(), record.size()) != (ssize_t)record.size()) {
+            std::cerr << "write manifest " << m_file << " failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        if (m_sync_every > 0 && ++m_unsynced >= m_sync_every) {
+            fdatasync(m_fd);
+            m_unsynced = 0;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef OTL_MANIFEST_H_
+#define OTL_MANIFEST_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace otl {
+    // size and modification time of an image, 0 if not known
+    struct FileStamp {
+        int64_t size = 0;
+        int64_t mtime_ns = 0;
+
+        bool known() const { return size != 0 || mtime_ns != 0; }
+        bool operator==(const FileStamp& other) const { return size == other.size && mtime_ns == other.mtime_ns; }
+    };
+
+    // size and modification time of path, unknown if stat fails
+    FileStamp stamp_file(const std::string& path);
+
+    // append-only record of the images whose results are saved, so a crashed or stopped run
+    // resumes where it ended. a line per image, written with one write(2) after its result file:
+    // a killed process loses nothing, a torn last line is ignored on load.
+    // the first line is the fingerprint of engine and config, a manifest of another fingerprint
+    // is started over.
+    class CompletionManifest {
+        public:
+        // sync_every > 0 fdatasyncs every sync_every records, for power loss
+        CompletionManifest(const std::string& file, uint64_t fingerprint, bool incremental, int sync_every);
+        ~CompletionManifest();
+
+        CompletionManifest(const CompletionManifest&) = delete;
+        CompletionManifest& operator=(const CompletionManifest&) = delete;
+
+        bool is_open() const { return m_fd >= 0; }
+
+        // images still to process, in order. a hash lookup per image, no stat; in incremental
+        // mode every image is stat'ed and completed images that changed since are pending too
+        std::vector<std::string> pending(const std::string& images_path, const std::vector<std::string>& images);
+
+        // the results of image are saved. thread safe
+        void complete(const std::string& image);
+
+        size_t completed() const { return m_done.size(); }
+        int64_t skipped() const { return m_skipped; }
+
+        private:
+        void load();
+        void restart();
+
+        std::string m_file;
+        uint64_t m_fingerprint;
+        bool m_incremental;
+        int m_sync_every;
+        int m_fd = -1;
+        int m_unsynced = 0;
+        int64_t m_skipped = 0;
+        std::mutex m_mutex;
+        std::unordered_map<std::string, FileStamp> m_done;      // image -> stamp when it was completed
+        std::unordered_map<std::string, FileStamp> m_stamps;    // incremental mode, stamps of pending images
+    };
+}
+
+#endif // OTL_MANIFEST_H_
@@ -0,0 +1,222 @@
+#include "metrics.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+namespace otl {
+    const int64_t Histogram::kBounds[Histogram::kBuckets] = {
+        100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+        1000000, 2500000, 10000000, INT64_MAX,
+    };
+
+    void Histogram::snapshot(std::vector<uint64_t>& counts, int64_t& sum_us) const {
+        counts.resize(kBuckets);
+        for (int i = 0; i < kBuckets; ++i) counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        sum_us = m_sum_us.load(std::memory_order_relaxed);
+    }
+
+    int64_t Histogram::quantile(const std::vector<uint64_t>& counts, double q) {
+        uint64_t total = 0;
+        for (uint64_t count : counts) total += count;
+        if (total == 0) return 0;
+        uint64_t target = uint64_t(q * total);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen > target) return i == kBuckets - 1 ? kBounds[kBuckets - 2] : kBounds[i];
+        }
+        return kBounds[kBuckets - 2];
+    }
+
+    Metrics& Metrics::instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    Metrics::Entry& Metrics::entry(const std::string& name, const std::string& labels, const std::string& help,
+                                metric_type type) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::unique_ptr<Entry>& entry : m_entries) {
+            if (entry->name == name && entry->labels == labels) return *entry;
+        }
+        Entry* entry = new Entry();
+        entry->name = name;
+        entry->labels = labels;
+        entry->help = help;
+        entry->type = type;
+        if (type == METRIC_COUNTER) entry->counter.reset(new Counter());
+        if (type == METRIC_GAUGE) entry->gauge.reset(new Gauge());
+        if (type == METRIC_HISTOGRAM) entry->histogram.reset(new Histogram());
+        m_entries.emplace_back(entry);
+        return *entry;
+    }
+
+    Counter& Metrics::counter(const std::string& name, const std::string& labels, const std::string& help) {
+        return *entry(name, labels, help, METRIC_COUNTER).counter;
+    }
+
+    Gauge& Metrics::gauge(const std::string& name, const std::string& labels, const std::string& help) {
+        return *entry(name, labels, help, METRIC_GAUGE).gauge;
+    }
+
+    Histogram& Metrics::histogram(const std::string& name, const std::string& labels, const std::string& help) {
+        return *entry(name, labels, help, METRIC_HISTOGRAM).histogram;
+    }
+
+    // text exposition format 0.0.4, histograms in seconds
+    std::string Metrics::prometheus() {
+        static const char* kTypes[] = {"counter", "gauge", "histogram"};
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ostringstream out;
+        std::vector<std::string> described;
+        std::vector<uint64_t> counts;
+        for (const std::unique_ptr<Entry>& entry : m_entries) {
+            // help and type once per name, entries of a name may have different labels
+            bool seen = false;
+            for (const std::string& name : described) seen = seen || name == entry->name;
+            if (!seen) {
+                out << "# HELP " << entry->name << " " << entry->help << "\n";
+                out << "# TYPE " << entry->name << " " << kTypes[entry->type] << "\n";
+                described.push_back(entry->name);
+            }
+            std::string labels = entry->labels.empty() ? "" : "{" + entry->labels + "}";
+            if (entry->type == METRIC_COUNTER) {
+                out << entry->name << labels << " " << entry->counter->value() << "\n";
+            } else if (entry->type == METRIC_GAUGE) {
+                out << entry->name << labels << " " << entry->gauge->value() << "\n";
+            } else {
+                int64_t sum_us;
+                entry->histogram->snapshot(counts, sum_us);
+                std::string prefix = entry->labels.empty() ? "" : entry->labels + ",";
+                uint64_t cumulative = 0;
+                for (int i = 0; i < Histogram::kBuckets; ++i) {
+                    cumulative += counts[i];
+                    out << entry->name << "_bucket{" << prefix << "le=\"";
+                    if (i == Histogram::kBuckets - 1) out << "+Inf";
+                    else out << Histogram::kBounds[i] / 1e6;
+                    out << "\"} " << cumulative << "\n";
+                }
+                out << entry->name << "_sum" << labels << " " << sum_us / 1e6 << "\n";
+                out << entry->name << "_count" << labels << " " << cumulative << "\n";
+            }
+        }
+        return out.str();
+    }
+
+    // one line, name{label=value} keys, histograms as count, mean and quantiles in ms
+    std::string Metrics::json() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ostringstream out;
+        out << "{\"ts_ms\": " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        std::vector<uint64_t> counts;
+        for (const std::unique_ptr<Entry>& entry : m_entries) {
+            std::string key = entry->name;
+            if (!entry->labels.empty()) {
+                std::string labels;
+                for (char c : entry->labels) if (c != '"') labels += c;
+                key += "{" + labels + "}";
+            }
+            out << ", \"" << key << "\": ";
+            if (entry->type == METRIC_COUNTER) {
+                out << entry->counter->value();
+            } else if (entry->type == METRIC_GAUGE) {
+                out << entry->gauge->value();
+            } else {
+                int64_t sum_us;
+                entry->histogram->snapshot(counts, sum_us);
+                uint64_t total = 0;
+                for (uint64_t count : counts) total += count;
+                out << "{\"count\": " << total << ", \"mean_ms\": " << (total ? sum_us / 1000.0 / total : 0.0)
+                    << ", \"p50_ms\": " << Histogram::quantile(counts, 0.5) / 1000.0
+                    << ", \"p99_ms\": " << Histogram::quantile(counts, 0.99) / 1000.0 << "}";
+            }
+        }
+        out << "}";
+        return out.str();
+    }
+
+    MetricsExporter::MetricsExporter(int port, int json_interval, const std::string& json_file)
+        : m_json_interval(json_interval), m_json_file(json_file) {
+        if (port > 0) {
+            sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            int reuse = 1;
+            m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (m_listen_fd >= 0) setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (m_listen_fd < 0 || bind(m_listen_fd, (sockaddr*)&address, sizeof(address)) != 0 ||
+                listen(m_listen_fd, 16) != 0) {
+                std::cerr << "metrics listen on 127.0.0.1:" << port << " failed: " << strerror(errno) << std::endl;
+                if (m_listen_fd >= 0) close(m_listen_fd);
+                m_listen_fd = -1;
+            } else {
+                std::cout << "Metrics on http://127.0.0.1:" << port << "/metrics" << std::endl;
+                m_server = std::thread(&MetricsExporter::serve, this);
+            }
+        }
+        if (json_interval > 0) {
+            m_logger = std::thread(&MetricsExporter::log_json, this);
+        }
+    }
+
+    MetricsExporter::~MetricsExporter() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cond.notify_all();
+        if (m_server.joinable()) m_server.join();
+        if (m_logger.joinable()) m_logger.join();
+        if (m_listen_fd >= 0) close(m_listen_fd);
+    }
+
+    // one request per connection, polled so the destructor is not blocked by accept
+    void MetricsExporter::serve() {
+        while (!m_stopped) {
+            pollfd listen_poll = {m_listen_fd, POLLIN, 0};
+            if (poll(&listen_poll, 1, 200) <= 0) continue;
+            int fd = accept(m_listen_fd, nullptr, nullptr);
+            if (fd < 0) continue;
+
+            // the request line is enough, headers are ignored
+            char request[1024];
+            pollfd request_poll = {fd, POLLIN, 0};
+            ssize_t size = poll(&request_poll, 1, 1000) > 0 ? recv(fd, request, sizeof(request) - 1, 0) : -1;
+            if (size > 0) {
+                request[size] = '\0';
+                bool json = strncmp(request, "GET /metrics.json", 17) == 0;
+                std::string body = json ? Metrics::instance().json() + "\n" : Metrics::instance().prometheus();
+                std::ostringstream response;
+                response << "HTTP/1.0 200 OK\r\nContent-Type: "
+                         << (json ? "application/json" : "text/plain; version=0.0.4")
+                         << "\r\nContent-Length: " << body.size() << "\r\nConnection: close\r\n\r\n" << body;
+                std::string data = response.str();
+                send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            }
+            close(fd);
+        }
+    }
+
+    void MetricsExporter::log_json() {
+        std::ofstream file;
+        if (!m_json_file.empty()) file.open(m_json_file, std::ios::app);
+        std::ostream& out = file.is_open() ? file : std::cout;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_cond.wait_for(lock, std::chrono::seconds(m_json_interval), [this] { return m_stopped.load(); })) {
+            out << Metrics::instance().json() << std::endl;
+        }
+        // final values of the run
+        out << Metrics::instance().json() << std::endl;
+    }
+}
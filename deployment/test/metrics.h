@@ -0,0 +1,143 @@
+#ifndef OTL_METRICS_H_
+#define OTL_METRICS_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+
+namespace otl {
+    // updates are relaxed atomics, no lock on the pipeline threads.
+    // metrics are registered once at startup and referenced afterwards.
+    class Counter {
+        public:
+        void inc(int64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+        int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+        private:
+        std::atomic<int64_t> m_value {0};
+    };
+
+    class Gauge {
+        public:
+        void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+        void add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+        int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+        private:
+        std::atomic<int64_t> m_value {0};
+    };
+
+    // latency histogram, microseconds into fixed buckets from 100us to 10s
+    class Histogram {
+        public:
+        static const int kBuckets = 16;
+        static const int64_t kBounds[kBuckets];     // upper bounds in us, the last bucket is +Inf
+
+        void observe(int64_t us) {
+            int bucket = 0;
+            while (bucket < kBuckets - 1 && us > kBounds[bucket]) bucket++;
+            m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+            m_sum_us.fetch_add(us, std::memory_order_relaxed);
+        }
+
+        // counts per bucket (not cumulative), sum of observations in us
+        void snapshot(std::vector<uint64_t>& counts, int64_t& sum_us) const;
+        // upper bound of the bucket holding the quantile, in us
+        static int64_t quantile(const std::vector<uint64_t>& counts, double q);
+
+        private:
+        std::atomic<uint64_t> m_buckets[kBuckets] = {};
+        std::atomic<int64_t> m_sum_us {0};
+    };
+
+    enum metric_type {
+        METRIC_COUNTER = 0,
+        METRIC_GAUGE = 1,
+        METRIC_HISTOGRAM = 2,
+    };
+
+    // process wide registry, exposed as prometheus text or one json object
+    class Metrics {
+        public:
+        static Metrics& instance();
+
+        // labels are prometheus label pairs, e.g. stage="detect", or empty.
+        // registering the same name and labels again returns the same metric
+        Counter& counter(const std::string& name, const std::string& labels, const std::string& help);
+        Gauge& gauge(const std::string& name, const std::string& labels, const std::string& help);
+        Histogram& histogram(const std::string& name, const std::string& labels, const std::string& help);
+
+        std::string prometheus();
+        std::string json();
+
+        private:
+        Metrics() = default;
+
+        struct Entry {
+            std::string name;
+            std::string labels;
+            std::string help;
+            metric_type type;
+            std::unique_ptr<Counter> counter;
+            std::unique_ptr<Gauge> gauge;
+            std::unique_ptr<Histogram> histogram;
+        };
+        Entry& entry(const std::string& name, const std::string& labels, const std::string& help, metric_type type);
+
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<Entry> > m_entries;
+    };
+
+    // observes the lifetime of the scope into a histogram
+    class MetricsTimer {
+        public:
+        explicit MetricsTimer(Histogram& histogram) : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+        ~MetricsTimer() {
+            m_histogram.observe(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - m_start).count());
+        }
+
+        MetricsTimer(const MetricsTimer&) = delete;
+        MetricsTimer& operator=(const MetricsTimer&) = delete;
+
+        private:
+        Histogram& m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // serves the registry on http://127.0.0.1:port/metrics (prometheus) and /metrics.json,
+    // and logs a json line every json_interval seconds. port or interval 0 disables that part.
+    class MetricsExporter {
+        public:
+        MetricsExporter(int port, int json_interval, const std::string& json_file);
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        private:
+        void serve();
+        void log_json();
+
+        int m_listen_fd = -1;
+        int m_json_interval;
+        std::string m_json_file;
+        std::atomic<bool> m_stopped {false};
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::thread m_server;
+        std::thread m_logger;
+    };
+}
+
+#define OTL_METRICS_CONCAT_INNER(a, b) a##b
+#define OTL_METRICS_CONCAT(a, b) OTL_METRICS_CONCAT_INNER(a, b)
+#define OTL_METRICS_TIMER(histogram) otl::MetricsTimer OTL_METRICS_CONCAT(metrics_timer_, __LINE__)(histogram)
+
+#endif // OTL_METRICS_H_
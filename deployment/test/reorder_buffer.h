@@ -0,0 +1,127 @@
+#ifndef OTL_REORDER_BUFFER_H_
+#define OTL_REORDER_BUFFER_H_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace otl {
+    // releases values in sequence order. a missing sequence blocks the ones behind it until it
+    // arrives, is skipped, or waited longer than the timeout (or more than capacity values are
+    // held), then the gap is given up and output goes on. a sequence arriving after its gap was
+    // given up is released right away, out of order. not thread safe, guarded by the result
+    // queue mutex of the pipeline
+    template <typename T>
+    class ReorderBuffer {
+        public:
+        struct Stats {
+            int64_t max_distance = 0;       // furthest a value arrived ahead of the head, in sequences
+            int64_t blocked_us = 0;         // total time a missing head held values back
+            int64_t max_blocked_us = 0;
+            int64_t gaps_given_up = 0;      // sequences released past on timeout or capacity
+            int64_t late = 0;               // values released out of order after their gap was given up
+        };
+
+        // timeout_us 0 waits for a missing sequence until capacity is reached
+        void reset(size_t capacity, int64_t timeout_us, int64_t first = 0) {
+            m_capacity = std::max<size_t>(capacity, 1);
+            m_timeout_us = timeout_us;
+            m_next = first;
+            m_blocked_since = -1;
+            m_pending.clear();
+            m_late.clear();
+            m_stats = Stats();
+        }
+
+        void push(int64_t seq, T&& value) {
+            if (seq < m_next) {
+                m_late.push_back(std::move(value));
+                m_stats.late++;
+                return;
+            }
+            m_stats.max_distance = std::max(m_stats.max_distance, seq - m_next);
+            Entry& entry = m_pending[seq];
+            entry.value = std::move(value);
+            entry.skipped = false;
+        }
+
+        // the sequence never arrives, e.g. the frame failed to decode or was dropped
+        void skip(int64_t seq) {
+            if (seq < m_next) return;
+            m_pending[seq].skipped = true;
+        }
+
+        // values released at now_us, appended to out in order
+        void pop(int64_t now_us, std::vector<T>& out) {
+            release(now_us, out);
+            while (!m_pending.empty() &&
+                   ((m_timeout_us > 0 && now_us - m_blocked_since >= m_timeout_us) || m_pending.size() > m_capacity)) {
+                // give up the gap in front of the oldest held value
+                m_stats.gaps_given_up += m_pending.begin()->first - m_next;
+                m_next = m_pending.begin()->first;
+                release(now_us, out);
+            }
+        }
+
+        // everything held, in order, at the end of the stream
+        void flush(int64_t now_us, std::vector<T>& out) {
+            release(now_us, out);
+            while (!m_pending.empty()) {
+                m_stats.gaps_given_up += m_pending.begin()->first - m_next;
+                m_next = m_pending.begin()->first;
+                release(now_us, out);
+            }
+        }
+
+        bool empty() const { return m_pending.empty() && m_late.empty(); }
+        size_t size() const { return m_pending.size() + m_late.size(); }
+
+        // time left until the missing head times out, -1 if nothing is held back
+        int64_t wait_us(int64_t now_us) const {
+            if (m_blocked_since < 0 || m_timeout_us <= 0) return -1;
+            return std::max<int64_t>(0, m_blocked_since + m_timeout_us - now_us);
+        }
+
+        const Stats& stats() const { return m_stats; }
+
+        private:
+        struct Entry {
+            T value;
+            bool skipped = true;
+        };
+
+        void release(int64_t now_us, std::vector<T>& out) {
+            for (T& value : m_late) out.push_back(std::move(value));
+            m_late.clear();
+            bool released = false;
+            while (!m_pending.empty() && m_pending.begin()->first == m_next) {
+                Entry& entry = m_pending.begin()->second;
+                if (!entry.skipped) out.push_back(std::move(entry.value));
+                m_pending.erase(m_pending.begin());
+                m_next++;
+                released = true;
+            }
+            if (released && m_blocked_since >= 0) {
+                int64_t blocked = now_us - m_blocked_since;
+                m_stats.blocked_us += blocked;
+                m_stats.max_blocked_us = std::max(m_stats.max_blocked_us, blocked);
+                m_blocked_since = -1;
+            }
+            // the head is missing whenever something is still held
+            if (m_pending.empty()) m_blocked_since = -1;
+            else if (m_blocked_since < 0) m_blocked_since = now_us;
+        }
+
+        size_t m_capacity = 64;
+        int64_t m_timeout_us = 0;
+        int64_t m_next = 0;
+        int64_t m_blocked_since = -1;
+        std::map<int64_t, Entry> m_pending;
+        std::vector<T> m_late;
+        Stats m_stats;
+    };
+}
+
+#endif // OTL_REORDER_BUFFER_H_
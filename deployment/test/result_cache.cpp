@@ -0,0 +1,201 @@
+#include "result_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+
+namespace otl {
+    static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+    static inline uint64_t rotl64(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static inline uint64_t read64(const uint8_t* p) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+        acc += input * PRIME64_2;
+        acc = rotl64(acc, 31);
+        return acc * PRIME64_1;
+    }
+
+    static inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t val) {
+        acc ^= xxh64_round(0, val);
+        return acc * PRIME64_1 + PRIME64_4;
+    }
+
+    uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* p = (const uint8_t*)data;
+        const uint8_t* end = p + size;
+        uint64_t h;
+
+        if (size >= 32) {
+            uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+            uint64_t v2 = seed + PRIME64_2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - PRIME64_1;
+            const uint8_t* limit = end - 32;
+            do {
+                v1 = xxh64_round(v1, read64(p));
+                v2 = xxh64_round(v2, read64(p + 8));
+                v3 = xxh64_round(v3, read64(p + 16));
+                v4 = xxh64_round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+            h = xxh64_merge_round(h, v1);
+            h = xxh64_merge_round(h, v2);
+            h = xxh64_merge_round(h, v3);
+            h = xxh64_merge_round(h, v4);
+        } else {
+            h = seed + PRIME64_5;
+        }
+        h += size;
+
+        for (; p + 8 <= end; p += 8) {
+            h ^= xxh64_round(0, read64(p));
+            h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        }
+        if (p + 4 <= end) {
+            h ^= (uint64_t)read32(p) * PRIME64_1;
+            h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h ^= (*p) * PRIME64_5;
+            h = rotl64(h, 11) * PRIME64_1;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME64_2;
+        h ^= h >> 29;
+        h *= PRIME64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    uint64_t hash_file(const std::string& path) {
+        FILE* fp = fopen(path.c_str(), "rb");
+        if (fp == NULL) return 0;
+        // chained hash of 4MB blocks, the engine files are big
+        std::vector<uint8_t> buffer(4 << 20);
+        uint64_t h = 0;
+        size_t read_size;
+        while ((read_size = fread(buffer.data(), 1, buffer.size(), fp)) > 0) {
+            h = hash_bytes(buffer.data(), read_size, h);
+        }
+        fclose(fp);
+        return h;
+    }
+
+    static const char kCacheMagic[8] = {'R', 'T', 'D', 'C', 'A', 'C', 'H', '1'};
+
+    ResultCache::ResultCache(size_t capacity, const std::string& cache_file, uint64_t context)
+        : m_capacity(capacity > 0 ? capacity : 1), m_cache_file(cache_file), m_context(context),
+          m_hits(0), m_misses(0) {
+        if (!m_cache_file.empty()) load();
+    }
+
+    ResultCache::~ResultCache() {
+        if (!m_cache_file.empty()) save();
+    }
+
+    bool ResultCache::get(uint64_t key, std::vector<detect_result>& results) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_index.find(key);
+        if (found == m_index.end()) {
+            m_misses++;
+            return false;
+        }
+        // move to front
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        results = found->second->second;
+        m_hits++;
+        return true;
+    }
+
+    void ResultCache::put(uint64_t key, const std::vector<detect_result>& results) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        insert(key, results);
+    }
+
+    void ResultCache::insert(uint64_t key, const std::vector<detect_result>& results) {
+        auto found = m_index.find(key);
+        if (found != m_index.end()) {
+            found->second->second = results;
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            return;
+        }
+        m_entries.emplace_front(key, results);
+        m_index[key] = m_entries.begin();
+        if (m_entries.size() > m_capacity) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+    }
+
+    // file layout: magic, then records of [key u64][count u32][count x detect_result],
+    // least recently used first so loading keeps the lru order
+    bool ResultCache::load() {
+        FILE* fp = fopen(m_cache_file.c_str(), "rb");
+        if (fp == NULL) return false;
+
+        char magic[8];
+        if (fread(magic, 1, sizeof(magic), fp) != sizeof(magic) || memcmp(magic, kCacheMagic, sizeof(magic)) != 0) {
+            std::cerr << "Ignore invalid result cache " << m_cache_file << std::endl;
+            fclose(fp);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t key;
+        uint32_t count;
+        std::vector<detect_result> results;
+        int loaded = 0;
+        while (fread(&key, sizeof(key), 1, fp) == 1 && fread(&count, sizeof(count), 1, fp) == 1) {
+            results.resize(count);
+            if (count > 0 && fread(results.data(), sizeof(detect_result), count, fp) != count) break;
+            insert(key, results);
+            loaded++;
+        }
+        fclose(fp);
+        std::cout << "Load " << loaded << " cached results from " << m_cache_file << std::endl;
+        return true;
+    }
+
+    bool ResultCache::save() {
+        // write a temp file and rename it, a crash never leaves a broken cache
+        std::string tmp_file = m_cache_file + ".tmp";
+        FILE* fp = fopen(tmp_file.c_str(), "wb");
+        if (fp == NULL) {
+            std::cerr << "open " << tmp_file << " failed." << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        fwrite(kCacheMagic, 1, sizeof(kCacheMagic), fp);
+        for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it) {
+            uint32_t count = it->second.size();
+            fwrite(&it->first, sizeof(it->first), 1, fp);
+            fwrite(&count, sizeof(count), 1, fp);
+            if (count > 0) fwrite(it->second.data(), sizeof(detect_result), count, fp);
+        }
+        bool ok = fclose(fp) == 0 && rename(tmp_file.c_str(), m_cache_file.c_str()) == 0;
+        if (!ok) std::cerr << "save result cache " << m_cache_file << " failed." << std::endl;
+        return ok;
+    }
+}
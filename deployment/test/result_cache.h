@@ -0,0 +1,68 @@
+#ifndef OTL_RESULT_CACHE_H_
+#define OTL_RESULT_CACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include "rtdetr.h"
+
+namespace otl {
+    // xxhash64 of bytes
+    uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+    // hash of a whole file, 0 if the file can not be read
+    uint64_t hash_file(const std::string& path);
+
+    // detection results keyed by the hash of the compressed image bytes and a context hash
+    // (engine, thresholds, input modes), so identical images skip decoding and inference.
+    // in-memory lru, optionally persisted to cache_file between runs.
+    class ResultCache {
+        public:
+        ResultCache(size_t capacity, const std::string& cache_file, uint64_t context);
+        ~ResultCache();
+
+        ResultCache(const ResultCache&) = delete;
+        ResultCache& operator=(const ResultCache&) = delete;
+
+        uint64_t key(const void* bytes, size_t size) const {
+            return hash_bytes(bytes, size, m_context);
+        }
+
+        bool get(uint64_t key, std::vector<detect_result>& results);
+
+        void put(uint64_t key, const std::vector<detect_result>& results);
+
+        bool load();
+
+        bool save();
+
+        uint64_t hits() const { return m_hits; }
+        uint64_t misses() const { return m_misses; }
+        double hit_rate() const {
+            uint64_t total = m_hits + m_misses;
+            return total > 0 ? m_hits * 1.0 / total : 0.0;
+        }
+
+        private:
+        typedef std::pair<uint64_t, std::vector<detect_result> > Entry;
+
+        void insert(uint64_t key, const std::vector<detect_result>& results);
+
+        size_t m_capacity;
+        std::string m_cache_file;
+        uint64_t m_context;
+        std::mutex m_mutex;
+        // most recently used first
+        std::list<Entry> m_entries;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+        std::atomic<uint64_t> m_hits;
+        std::atomic<uint64_t> m_misses;
+    };
+}
+
+#endif // OTL_RESULT_CACHE_H_
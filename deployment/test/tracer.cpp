@@ -0,0 +1,102 @@
+#include "tracer.h"
+
+#include <stdio.h>
+#include <iostream>
+#include <fstream>
+
+namespace otl {
+    Tracer& Tracer::instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void Tracer::enable(const std::string& trace_file, int buffer_size) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_trace_file = trace_file;
+        m_buffer_size = buffer_size > 0 ? buffer_size : 1;
+        m_start = std::chrono::steady_clock::now();
+        m_enabled = true;
+    }
+
+    TraceBuffer* Tracer::local_buffer() {
+        // buffers are owned by tracer, so they outlive the recording threads
+        static thread_local TraceBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            TraceBuffer* new_buffer = new TraceBuffer();
+            new_buffer->tid = m_buffers.size() + 1;
+            new_buffer->thread_name = "thread_" + std::to_string(new_buffer->tid);
+            new_buffer->events.resize(m_buffer_size);
+            new_buffer->count = 0;
+            m_buffers.emplace_back(new_buffer);
+            buffer = new_buffer;
+        }
+        return buffer;
+    }
+
+    void Tracer::record(const char* name, char phase, int64_t ts, int64_t dur, int64_t value) {
+        TraceBuffer* buffer = local_buffer();
+        uint64_t count = buffer->count.load(std::memory_order_relaxed);
+        TraceEvent& event = buffer->events[count % buffer->events.size()];
+        event.name = name;
+        event.phase = phase;
+        event.ts = ts;
+        event.dur = dur;
+        event.value = value;
+        buffer->count.store(count + 1, std::memory_order_release);
+    }
+
+    void Tracer::set_thread_name(const char* name) {
+        TraceBuffer* buffer = local_buffer();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffer->thread_name = name;
+    }
+
+    bool Tracer::dump() {
+        if (!enabled()) return false;
+        // stop recording, the pipeline threads should be joined already
+        m_enabled = false;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ofstream out(m_trace_file);
+        if (!out.is_open()) {
+            std::cerr << "open trace file " << m_trace_file << " failed." << std::endl;
+            return false;
+        }
+
+        uint64_t total = 0, dropped = 0;
+        bool first = true;
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (auto& buffer : m_buffers) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+
+            uint64_t count = buffer->count.load(std::memory_order_acquire);
+            uint64_t size = buffer->events.size();
+            uint64_t begin = count > size ? count - size : 0;
+            dropped += begin;
+            for (uint64_t i = begin; i < count; ++i) {
+                const TraceEvent& event = buffer->events[i % size];
+                out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+                    << "\",\"ts\":" << event.ts << ",\"pid\":1,\"tid\":" << buffer->tid;
+                if (event.phase == 'X') {
+                    out << ",\"dur\":" << event.dur << ",\"args\":{\"frame\":" << event.value << "}";
+                } else if (event.phase == 'C') {
+                    out << ",\"args\":{\"value\":" << event.value << "}";
+                } else {
+                    out << ",\"cat\":\"queue\",\"id\":" << event.value << ",\"args\":{\"frame\":" << event.value << "}";
+                }
+                out << "}";
+                total++;
+            }
+        }
+        out << "\n]}\n";
+        out.close();
+
+        std::cout << "Trace: " << total << " events of " << m_buffers.size() << " threads written to "
+                << m_trace_file << ", " << dropped << " events overwritten." << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef OTL_TRACER_H_
+#define OTL_TRACER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+namespace otl {
+    // one trace event, names must be string literals
+    struct TraceEvent {
+        const char* name;
+        char phase;         // 'X' complete, 'b'/'e' async begin/end, 'C' counter
+        int64_t ts;         // us since tracer enabled
+        int64_t dur;        // us, only for 'X'
+        int64_t value;      // frame id, or counter value for 'C'
+    };
+
+    // single writer ring buffer owned by one thread
+    struct TraceBuffer {
+        int tid;
+        std::string thread_name;
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> count;
+    };
+
+    // records chrome://tracing events into per-thread ring buffers,
+    // dump() writes them as trace event json, viewable in chrome://tracing or perfetto.
+    class Tracer {
+        public:
+        static Tracer& instance();
+
+        void enable(const std::string& trace_file, int buffer_size);
+
+        bool enabled() const {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        int64_t now() const {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - m_start).count();
+        }
+
+        void record(const char* name, char phase, int64_t ts, int64_t dur, int64_t value);
+
+        void set_thread_name(const char* name);
+
+        // write all buffered events to trace file
+        bool dump();
+
+        private:
+        Tracer() = default;
+        TraceBuffer* local_buffer();
+
+        std::atomic<bool> m_enabled {false};
+        std::chrono::steady_clock::time_point m_start;
+        std::string m_trace_file;
+        int m_buffer_size = 0;
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<TraceBuffer> > m_buffers;
+    };
+
+    // trace a stage from construction to destruction as one complete event
+    class TraceScope {
+        public:
+        TraceScope(const char* name, int64_t frame_id) : m_name(name), m_frame_id(frame_id), m_start(-1) {
+            Tracer& tracer = Tracer::instance();
+            if (tracer.enabled()) m_start = tracer.now();
+        }
+
+        ~TraceScope() {
+            if (m_start >= 0) {
+                Tracer& tracer = Tracer::instance();
+                tracer.record(m_name, 'X', m_start, tracer.now() - m_start, m_frame_id);
+            }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+        private:
+        const char* m_name;
+        int64_t m_frame_id;
+        int64_t m_start;
+    };
+
+    // frame enters a queue, may be left on another thread
+    static inline void trace_async_begin(const char* name, int64_t frame_id) {
+        Tracer& tracer = Tracer::instance();
+        if (tracer.enabled()) tracer.record(name, 'b', tracer.now(), 0, frame_id);
+    }
+
+    static inline void trace_async_end(const char* name, int64_t frame_id) {
+        Tracer& tracer = Tracer::instance();
+        if (tracer.enabled()) tracer.record(name, 'e', tracer.now(), 0, frame_id);
+    }
+
+    static inline void trace_counter(const char* name, int64_t value) {
+        Tracer& tracer = Tracer::instance();
+        if (tracer.enabled()) tracer.record(name, 'C', tracer.now(), 0, value);
+    }
+
+    static inline void trace_thread_name(const char* name) {
+        Tracer& tracer = Tracer::instance();
+        if (tracer.enabled()) tracer.set_thread_name(name);
+    }
+}
+
+#define OTL_TRACE_CONCAT_INNER(a, b) a##b
+#define OTL_TRACE_CONCAT(a, b) OTL_TRACE_CONCAT_INNER(a, b)
+#define OTL_TRACE_SCOPE(name, frame_id) otl::TraceScope OTL_TRACE_CONCAT(trace_scope_, __LINE__)(name, frame_id)
+
+#endif // OTL_TRACER_H_
@@ -0,0 +1,155 @@
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <chrono>
+
+#include "NvInfer.h"
+#include "NvOnnxParser.h"
+
+#include "rtdetr_utils.h"
+#include "rtdetr_calibrator.h"
+
+// builds an int8 engine from the onnx model, calibrated with images of the target data.
+// the calibration table is cached, later builds (or trtexec --int8 --calib=) skip calibration.
+
+class Logger : public nvinfer1::ILogger {
+    void log(Severity severity, const char* msg) noexcept override {
+        if (severity <= Severity::kWARNING) {
+            std::cout << msg << std::endl;
+        }
+    }
+};
+
+struct Options {
+    std::string onnx;
+    std::string images;
+    std::string engine = "rtdetr-l_int8.engine";
+    std::string cache = "rtdetr-l_int8.cache";
+    int batch_size = 8;     // only used if the onnx batch dimension is dynamic
+    int max_batches = 64;
+    int input_size = 640;   // only used by --dry-run, otherwise the onnx input size
+    bool dry_run = false;
+    size_t workspace_mb = 4096;
+};
+
+static void usage() {
+    std::cout << "Usage: rtdetr_int8 --onnx model.onnx --images calib_dir [--engine out.engine] [--cache calib.cache]\n"
+              << "                   [--batch 8] [--max-batches 64] [--workspace 4096] [--dry-run [--size 640]]\n"
+              << "--dry-run only streams the calibration batches, no gpu is used." << std::endl;
+}
+
+// runs the batch producer alone and prints what calibration would see
+static int dry_run(const Options& options, const std::vector<std::string>& images) {
+    seeta::CalibrationStream stream(images, options.batch_size, options.input_size, options.input_size,
+                                    options.max_batches);
+    std::vector<float> batch;
+    int batches = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    while (stream.next(batch)) {
+        double sum = 0.0;
+        for (float value : batch) sum += value;
+        std::cout << "batch " << batches++ << ": " << batch.size() << " floats, mean " << sum / batch.size() << std::endl;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::cout << "Streamed " << batches << "/" << stream.batches_num() << " batches in " << duration.count() << "ms" << std::endl;
+    return batches == stream.batches_num() ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--onnx") {
+            options.onnx = argv[++i];
+        } else if (i + 1 < argc && arg == "--images") {
+            options.images = argv[++i];
+        } else if (i + 1 < argc && arg == "--engine") {
+            options.engine = argv[++i];
+        } else if (i + 1 < argc && arg == "--cache") {
+            options.cache = argv[++i];
+        } else if (i + 1 < argc && arg == "--batch") {
+            options.batch_size = atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--max-batches") {
+            options.max_batches = atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--size") {
+            options.input_size = atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--workspace") {
+            options.workspace_mb = atoi(argv[++i]);
+        } else if (arg == "--dry-run") {
+            options.dry_run = true;
+        } else {
+            usage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (options.images.empty() || (options.onnx.empty() && !options.dry_run)) {
+        usage();
+        return -1;
+    }
+
+    std::vector<std::string> images = seeta::FindFilesRecursively(options.images, -1);
+    for (std::string& image : images) {
+        image = options.images + seeta::FileSeparator() + image;
+    }
+    std::cout << "Found " << images.size() << " calibration images." << std::endl;
+
+    if (options.dry_run) {
+        return dry_run(options, images);
+    }
+
+    Logger logger;
+    std::unique_ptr<nvinfer1::IBuilder> builder(nvinfer1::createInferBuilder(logger));
+    if (!builder->platformHasFastInt8()) {
+        std::cout << "Warning: the gpu has no fast int8, the engine may be slower than fp16." << std::endl;
+    }
+    uint32_t flags = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+    std::unique_ptr<nvinfer1::INetworkDefinition> network(builder->createNetworkV2(flags));
+    std::unique_ptr<nvonnxparser::IParser> parser(nvonnxparser::createParser(*network, logger));
+    if (!parser->parseFromFile(options.onnx.c_str(), static_cast<int>(nvinfer1::ILogger::Severity::kWARNING))) {
+        std::cerr << "parse " << options.onnx << " failed." << std::endl;
+        return -1;
+    }
+
+    // nchw input, the batch comes from the onnx model unless it is dynamic
+    nvinfer1::ITensor* input = network->getInput(0);
+    nvinfer1::Dims dims = input->getDimensions();
+    std::unique_ptr<nvinfer1::IBuilderConfig> config(builder->createBuilderConfig());
+    int batch_size = dims.d[0] > 0 ? dims.d[0] : options.batch_size;
+    if (dims.d[0] <= 0) {
+        dims.d[0] = batch_size;
+        nvinfer1::IOptimizationProfile* profile = builder->createOptimizationProfile();
+        profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMIN, dims);
+        profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kOPT, dims);
+        profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMAX, dims);
+        config->addOptimizationProfile(profile);
+        config->setCalibrationProfile(profile);
+    }
+    std::cout << "Calibration input " << batch_size << "x" << dims.d[1] << "x" << dims.d[2] << "x" << dims.d[3] << std::endl;
+
+    seeta::CalibrationStream stream(images, batch_size, dims.d[3], dims.d[2], options.max_batches);
+    seeta::Int8Calibrator calibrator(stream, options.cache);
+
+    // int8 with fp16 fallback for the layers without int8 kernels
+    config->setFlag(nvinfer1::BuilderFlag::kINT8);
+    config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    config->setInt8Calibrator(&calibrator);
+    config->setMemoryPoolLimit(nvinfer1::MemoryPoolType::kWORKSPACE, options.workspace_mb << 20);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<nvinfer1::IHostMemory> serialized(builder->buildSerializedNetwork(*network, *config));
+    if (!serialized) {
+        std::cerr << "build int8 engine failed." << std::endl;
+        return -1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::cout << "Build engine spent " << duration.count() << "ms" << std::endl;
+
+    std::ofstream out(options.engine, std::ios::binary);
+    out.write((const char*)serialized->data(), serialized->size());
+    out.close();
+    std::cout << "Write engine to " << options.engine << std::endl;
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "rtdetr_utils.h"
+#include "rtdetr_eval.h"
+
+// evaluates result directories against ground truth (precision, recall, ap per class, map)
+// and diffs two result sets image by image, e.g. the python reference against the engine.
+// result files are paired by base name, the format comes from the extension.
+
+typedef bool (*result_reader)(const std::string&, std::vector<detect_result>&);
+
+// readers by file extension, new result formats are added here
+static const std::map<std::string, result_reader> kResultFormats = {
+    {"txt", seeta::read_results},
+    {"bin", seeta::read_results_binary},
+};
+
+struct Options {
+    std::string gt;
+    std::string a;
+    std::string b;
+    float iou = 0.5f;
+    bool coco = false;          // map over iou 0.5:0.05:0.95 too
+    float score = 0.2f;         // operating point of precision/recall and the diff
+    float diff_iou = 0.5f;
+    float score_tol = 0.05f;
+    int threads = 0;
+    std::string diffs;          // per image diff report
+};
+
+// one result set, base name -> file
+struct ResultSet {
+    std::string path;
+    std::map<std::string, std::string> files;
+};
+
+struct ImageEval {
+    std::string name;
+    std::vector<seeta::image_matches> a_matches;    // per iou threshold
+    std::vector<seeta::image_matches> b_matches;
+    seeta::image_diff diff;
+    bool read_failed = false;
+};
+
+static void usage() {
+    std::cout << "Usage: rtdetr_eval [--gt gt_dir] --a results_dir [--b results_dir] [--iou 0.5] [--coco]\n"
+              << "                   [--score 0.2] [--diff-iou 0.5] [--score-tol 0.05] [--threads N] [--diffs diffs.txt]\n"
+              << "with --gt: precision/recall/map of a (and b). with --b: per image regressions of b against a.\n"
+              << "results are txt (write_results, predict.py) or bin (write_results_binary), gt may be \"cls x1 y1 x2 y2\" txt."
+              << std::endl;
+}
+
+static ResultSet list_results(const std::string& path) {
+    ResultSet set;
+    set.path = path;
+    for (const std::string& name : seeta::FindFilesRecursively(path, -1)) {
+        size_t dot = name.rfind('.');
+        if (dot == std::string::npos || kResultFormats.count(name.substr(dot + 1)) == 0) continue;
+        set.files[name.substr(0, dot)] = path + seeta::FileSeparator() + name;
+    }
+    return set;
+}
+
+// a missing file is an image without boxes
+static bool load_results(const ResultSet& set, const std::string& name, std::vector<detect_result>& results) {
+    results.clear();
+    auto file = set.files.find(name);
+    if (file == set.files.end()) return true;
+    std::string extension = file->second.substr(file->second.rfind('.') + 1);
+    return kResultFormats.at(extension)(file->second, results);
+}
+
+static void evaluate_image(const Options& options, const std::vector<float>& thresholds, const ResultSet& gt_set,
+                        const ResultSet& a_set, const ResultSet& b_set, ImageEval& eval) {
+    std::vector<detect_result> gt, a, b;
+    bool ok = load_results(a_set, eval.name, a);
+    if (!options.gt.empty()) ok = load_results(gt_set, eval.name, gt) && ok;
+    if (!options.b.empty()) ok = load_results(b_set, eval.name, b) && ok;
+    eval.read_failed = !ok;
+    if (!options.gt.empty()) {
+        for (float iou : thresholds) {
+            eval.a_matches.push_back(seeta::match_image(gt, a, iou));
+            if (!options.b.empty()) eval.b_matches.push_back(seeta::match_image(gt, b, iou));
+        }
+    }
+    if (!options.b.empty()) {
+        eval.diff = seeta::diff_image(a, b, options.score, options.diff_iou, options.score_tol);
+    }
+}
+
+// per class ap at the first threshold, map at every threshold, precision/recall at the score
+static void report_metrics(const std::string& title, const Options& options, const std::vector<float>& thresholds,
+                        std::vector<seeta::image_matches>& totals) {
+    std::cout << std::endl << "== " << title << " ==" << std::endl;
+    std::vector<float> maps;
+    for (size_t t = 0; t < thresholds.size(); ++t) {
+        float sum = 0.0f;
+        int classes = 0;
+        for (auto& item : totals[t]) {
+            if (item.second.gt_num == 0) continue;
+            float ap = seeta::average_precision(item.second);
+            sum += ap;
+            classes++;
+            if (t == 0) {
+                int tp = 0, fp = 0;
+                for (const auto& detection : item.second.detections) {
+                    if (detection.first >= options.score) detection.second ? tp++ : fp++;
+                }
+                std::cout << "class " << std::setw(4) << item.first << "  gt " << std::setw(7) << item.second.gt_num
+                        << "  AP" << int(thresholds[0] * 100 + 0.5f) << " " << std::fixed << std::setprecision(4) << ap
+                        << "  P " << (tp + fp > 0 ? tp * 1.0f / (tp + fp) : 0.0f)
+                        << "  R " << tp * 1.0f / item.second.gt_num << std::defaultfloat << std::endl;
+            }
+        }
+        maps.push_back(classes > 0 ? sum / classes : 0.0f);
+    }
+
+    // precision/recall over all classes at the score
+    int tp = 0, fp = 0, gt_num = 0;
+    for (const auto& item : totals[0]) {
+        gt_num += item.second.gt_num;
+        for (const auto& detection : item.second.detections) {
+            if (detection.first >= options.score) detection.second ? tp++ : fp++;
+        }
+    }
+    std::cout << std::fixed << std::setprecision(4) << "mAP" << int(thresholds[0] * 100 + 0.5f) << ": " << maps[0];
+    if (options.coco) {
+        float sum = 0.0f;
+        for (float map : maps) sum += map;
+        std::cout << "  mAP50-95: " << sum / maps.size();
+    }
+    std::cout << "  precision@" << options.score << ": " << (tp + fp > 0 ? tp * 1.0f / (tp + fp) : 0.0f)
+            << "  recall@" << options.score << ": " << (gt_num > 0 ? tp * 1.0f / gt_num : 0.0f)
+            << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--gt") {
+            options.gt = argv[++i];
+        } else if (i + 1 < argc && arg == "--a") {
+            options.a = argv[++i];
+        } else if (i + 1 < argc && arg == "--b") {
+            options.b = argv[++i];
+        } else if (i + 1 < argc && arg == "--iou") {
+            options.iou = atof(argv[++i]);
+        } else if (arg == "--coco") {
+            options.coco = true;
+        } else if (i + 1 < argc && arg == "--score") {
+            options.score = atof(argv[++i]);
+        } else if (i + 1 < argc && arg == "--diff-iou") {
+            options.diff_iou = atof(argv[++i]);
+        } else if (i + 1 < argc && arg == "--score-tol") {
+            options.score_tol = atof(argv[++i]);
+        } else if (i + 1 < argc && arg == "--threads") {
+            options.threads = atoi(argv[++i]);
+        } else if (i + 1 < argc && arg == "--diffs") {
+            options.diffs = argv[++i];
+        } else {
+            usage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (options.a.empty() || (options.gt.empty() && options.b.empty())) {
+        usage();
+        return -1;
+    }
+    int threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<float> thresholds(1, options.iou);
+    if (options.coco) {
+        thresholds.clear();
+        for (int i = 0; i < 10; ++i) thresholds.push_back(0.5f + 0.05f * i);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ResultSet gt_set, a_set = list_results(options.a), b_set;
+    if (!options.gt.empty()) gt_set = list_results(options.gt);
+    if (!options.b.empty()) b_set = list_results(options.b);
+
+    // images of the ground truth, or of both result sets for a pure diff
+    std::vector<ImageEval> evals;
+    const ResultSet& reference = options.gt.empty() ? a_set : gt_set;
+    for (const auto& file : reference.files) {
+        evals.push_back(ImageEval());
+        evals.back().name = file.first;
+    }
+    if (options.gt.empty()) {
+        for (const auto& file : b_set.files) {
+            if (a_set.files.count(file.first) == 0) {
+                evals.push_back(ImageEval());
+                evals.back().name = file.first;
+            }
+        }
+    }
+    std::cout << "Images: " << evals.size() << ", gt files: " << gt_set.files.size() << ", a files: "
+            << a_set.files.size() << ", b files: " << b_set.files.size() << ", threads: " << threads << std::endl;
+
+    // files are read and matched in parallel, every image is owned by one thread
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            size_t i;
+            while ((i = next++) < evals.size()) {
+                evaluate_image(options, thresholds, gt_set, a_set, b_set, evals[i]);
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    int read_failed = 0;
+    for (const ImageEval& eval : evals) read_failed += eval.read_failed;
+    if (read_failed > 0) {
+        std::cout << "Warning: " << read_failed << " images have unreadable result files." << std::endl;
+    }
+
+    if (!options.gt.empty()) {
+        std::vector<seeta::image_matches> a_totals(thresholds.size()), b_totals(thresholds.size());
+        for (const ImageEval& eval : evals) {
+            for (size_t t = 0; t < thresholds.size(); ++t) {
+                seeta::merge_matches(a_totals[t], eval.a_matches[t]);
+                if (!options.b.empty()) seeta::merge_matches(b_totals[t], eval.b_matches[t]);
+            }
+        }
+        report_metrics("a: " + options.a, options, thresholds, a_totals);
+        if (!options.b.empty()) report_metrics("b: " + options.b, options, thresholds, b_totals);
+    }
+
+    int result = 0;
+    if (!options.b.empty()) {
+        // worst images first
+        std::vector<const ImageEval*> changed;
+        int missing = 0, extra = 0, score_changed = 0;
+        float max_shift = 0.0f;
+        for (const ImageEval& eval : evals) {
+            missing += eval.diff.missing;
+            extra += eval.diff.extra;
+            score_changed += eval.diff.score_changed;
+            max_shift = std::max(max_shift, eval.diff.max_shift);
+            if (eval.diff.changed()) changed.push_back(&eval);
+        }
+        std::stable_sort(changed.begin(), changed.end(), [](const ImageEval* x, const ImageEval* y) {
+            return x->diff.missing + x->diff.extra > y->diff.missing + y->diff.extra;
+        });
+        std::cout << std::endl << "== diff b against a, boxes with score >= " << options.score << " ==" << std::endl;
+        std::cout << "Changed images: " << changed.size() << "/" << evals.size() << ", missing boxes: " << missing
+                << ", extra boxes: " << extra << ", score changed: " << score_changed
+                << ", max matched shift: " << max_shift << "px" << std::endl;
+
+        std::ofstream out;
+        if (!options.diffs.empty()) out.open(options.diffs);
+        for (size_t i = 0; i < changed.size(); ++i) {
+            const ImageEval& eval = *changed[i];
+            std::ostringstream line;
+            line << eval.name << " missing " << eval.diff.missing << " extra " << eval.diff.extra << " score_changed "
+                << eval.diff.score_changed << " max_shift " << eval.diff.max_shift << " min_iou " << eval.diff.min_iou;
+            if (out.is_open()) out << line.str() << std::endl;
+            if (i < 20) std::cout << "  " << line.str() << std::endl;
+        }
+        if (changed.size() > 20) std::cout << "  ... " << changed.size() - 20 << " more" << std::endl;
+        if (out.is_open()) std::cout << "Write per image diffs to " << options.diffs << std::endl;
+        result = changed.empty() ? 0 : 1;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
+    std::cout << "Evaluation spent " << duration.count() << "ms" << std::endl;
+    return result;
+}
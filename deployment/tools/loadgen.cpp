@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+extern "C" {
+#include "iniparser.h"
+}
+
+// synthetic end to end load of pipeline patterns 1-5. images of one size and format are
+// generated into a directory, tmpfs (/dev/shm) by default so the disk is out of the picture,
+// then every pattern runs in its own process of the test executable on a copy of config.ini
+// pointing at them. the pipelines pace the frames at --rate and append a json line of
+// throughput, latency, cpu and peak memory (see LoadReport); the lines are collected into one report.
+// ./test_mock runs the pipelines on a simulated engine, ./test on the real one
+
+struct Options {
+    int width = 1920;
+    int height = 1080;
+    std::string format = "jpg";
+    int images = 500;
+    int distinct = 16;
+    double rate = 0.0;
+    std::string dir = "/dev/shm/rtdetr_loadgen";
+    std::string patterns = "1,2,3,4,5";
+    std::string exe = "./test";
+    std::string config = "config.ini";
+    std::string model;
+    std::string report = "loadgen.json";
+};
+
+static void usage() {
+    std::cout << "Usage: rtdetr_loadgen [--exe ./test] [--config config.ini] [--model mock:640:8000]\n"
+              << "                      [--width 1920] [--height 1080] [--format jpg|png|bmp] [--images 500]\n"
+              << "                      [--distinct 16] [--rate 0] [--dir /dev/shm/rtdetr_loadgen]\n"
+              << "                      [--patterns 1,2,3,4,5] [--report loadgen.json]\n"
+              << "--rate is the arrival rate in frames per second, 0 reads frames as fast as each pattern takes them.\n"
+              << "--dir on a disk instead of a tmpfs includes file reads from disk (once out of the page cache).\n"
+              << "--model overrides DETECTOR_MODEL, e.g. mock:input_size:engine_us[:batch] for ./test_mock." << std::endl;
+}
+
+static bool make_directory(const std::string& path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        std::string part = path.substr(0, pos);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (pos == std::string::npos) return true;
+    }
+}
+
+static void remove_files(const std::string& dir) {
+    DIR* handle = opendir(dir.c_str());
+    if (handle == nullptr) return;
+    while (dirent* entry = readdir(handle)) {
+        if (entry->d_name[0] == '.') continue;
+        unlink((dir + "/" + entry->d_name).c_str());
+    }
+    closedir(handle);
+}
+
+static std::string absolute_path(const std::string& path) {
+    char resolved[PATH_MAX];
+    return realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+}
+
+// noise with a few shapes, so the codecs work like on camera frames. the frame number is
+// drawn into every image, no two files are identical for the result cache
+static int synthesize_images(const Options& options, const std::string& images_dir) {
+    cv::RNG rng(12345);
+    std::vector<cv::Mat> bases;
+    for (int i = 0; i < options.distinct; ++i) {
+        cv::Mat base(options.height, options.width, CV_8UC3);
+        rng.fill(base, cv::RNG::UNIFORM, cv::Scalar(0, 0, 0), cv::Scalar(96, 96, 96));
+        cv::GaussianBlur(base, base, cv::Size(5, 5), 0);
+        for (int k = 0; k < 12; ++k) {
+            cv::Point center(rng.uniform(0, options.width), rng.uniform(0, options.height));
+            cv::Size size(rng.uniform(options.width / 40, options.width / 6), rng.uniform(options.height / 40, options.height / 6));
+            cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+            if (k % 2) {
+                cv::rectangle(base, cv::Rect(center, size), color, cv::FILLED);
+            } else {
+                cv::ellipse(base, center, size, 0, 0, 360, color, cv::FILLED);
+            }
+        }
+        bases.push_back(base);
+    }
+
+    remove_files(images_dir);
+    std::vector<unsigned char> bytes;
+    cv::Mat image;
+    for (int i = 0; i < options.images; ++i) {
+        bases[i % bases.size()].copyTo(image);
+        cv::putText(image, std::to_string(i), cv::Point(16, 48), cv::FONT_HERSHEY_SIMPLEX, 1.5, cv::Scalar(255, 255, 255), 3);
+        if (!cv::imencode("." + options.format, image, bytes)) {
+            std::cerr << "encode ." << options.format << " failed." << std::endl;
+            return -1;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%06d.%s", i, options.format.c_str());
+        std::ofstream file(images_dir + "/" + name, std::ios::binary);
+        if (!file.write((const char*)bytes.data(), bytes.size())) {
+            std::cerr << "write " << images_dir << "/" << name << " failed." << std::endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// config.ini of the runs: the base config on the synthetic images. resuming and the result
+// cache would skip frames of later runs, they are off
+static bool write_run_config(const Options& options, const std::string& run_config) {
+    dictionary* ini = iniparser_load(options.config.c_str());
+    if (ini == nullptr) {
+        std::cerr << "load " << options.config << " failed." << std::endl;
+        return false;
+    }
+    std::ostringstream rate;
+    rate << options.rate;
+    std::string model = options.model.empty() ? absolute_path(iniparser_getstring(ini, "model:DETECTOR_MODEL", ""))
+                                              : options.model;
+    const char* sections[] = {"model", "parameter", "cache", "manifest", "loadgen"};
+    for (const char* section : sections) {
+        if (iniparser_find_entry(ini, section) == 0) iniparser_set(ini, section, nullptr);
+    }
+    iniparser_set(ini, "model:DETECTOR_MODEL", model.c_str());
+    iniparser_set(ini, "parameter:IMAGE_PATH", (options.dir + "/images").c_str());
+    iniparser_set(ini, "parameter:SAVE_PATH", (options.dir + "/results").c_str());
+    iniparser_set(ini, "cache:ENABLE", "0");
+    iniparser_set(ini, "manifest:MANIFEST_FILE", "");
+    iniparser_set(ini, "loadgen:ARRIVAL_FPS", rate.str().c_str());
+    iniparser_set(ini, "loadgen:REPORT_FILE", (options.dir + "/report.jsonl").c_str());
+
+    FILE* file = fopen(run_config.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "write " << run_config << " failed: " << strerror(errno) << std::endl;
+        iniparser_freedict(ini);
+        return false;
+    }
+    iniparser_dump_ini(ini, file);
+    fclose(file);
+    iniparser_freedict(ini);
+    return true;
+}
+
+// runs "exe pattern" in dir with its output in dir/pattern_N.log, the exit status or -1
+static int run_pattern(const Options& options, const std::string& exe, int pattern) {
+    std::string log = options.dir + "/pattern_" + std::to_string(pattern) + ".log";
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        std::string code = std::to_string(pattern);
+        if (chdir(options.dir.c_str()) == 0) execl(exe.c_str(), exe.c_str(), code.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0) return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// lines appended to the report file since offset
+static std::vector<std::string> read_report_lines(const std::string& file, std::streamoff& offset) {
+    std::vector<std::string> lines;
+    std::ifstream in(file);
+    if (!in.is_open()) return lines;
+    in.seekg(offset);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) lines.push_back(line);
+    }
+    in.clear();
+    in.seekg(0, std::ios::end);
+    offset = in.tellg();
+    return lines;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--width") {
+            options.width = std::max(16, atoi(argv[++i]));
+        } else if (i + 1 < argc && arg == "--height") {
+            options.height = std::max(16, atoi(argv[++i]));
+        } else if (i + 1 < argc && arg == "--format") {
+            options.format = argv[++i];
+        } else if (i + 1 < argc && arg == "--images") {
+            options.images = std::max(1, atoi(argv[++i]));
+        } else if (i + 1 < argc && arg == "--distinct") {
+            options.distinct = std::max(1, atoi(argv[++i]));
+        } else if (i + 1 < argc && arg == "--rate") {
+            options.rate = std::max(0.0, atof(argv[++i]));
+        } else if (i + 1 < argc && arg == "--dir") {
+            options.dir = argv[++i];
+        } else if (i + 1 < argc && arg == "--patterns") {
+            options.patterns = argv[++i];
+        } else if (i + 1 < argc && arg == "--exe") {
+            options.exe = argv[++i];
+        } else if (i + 1 < argc && arg == "--config") {
+            options.config = argv[++i];
+        } else if (i + 1 < argc && arg == "--model") {
+            options.model = argv[++i];
+        } else if (i + 1 < argc && arg == "--report") {
+            options.report = argv[++i];
+        } else {
+            usage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (options.format != "jpg" && options.format != "png" && options.format != "bmp") {
+        usage();
+        return -1;
+    }
+    std::vector<int> patterns;
+    std::stringstream items(options.patterns);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        int pattern = atoi(item.c_str());
+        if (pattern >= 1 && pattern <= 5) patterns.push_back(pattern);
+    }
+
+    if (!make_directory(options.dir + "/images") || !make_directory(options.dir + "/results")) {
+        std::cerr << "create " << options.dir << " failed: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    // the runs work in dir, paths in their config are absolute
+    options.dir = absolute_path(options.dir);
+    std::string images_dir = options.dir + "/images";
+    auto start = std::chrono::steady_clock::now();
+    if (synthesize_images(options, images_dir) != 0) return -1;
+    std::chrono::duration<double> synthesis = std::chrono::steady_clock::now() - start;
+    std::cout << "Synthesized " << options.images << " " << options.width << "x" << options.height << " "
+            << options.format << " images into " << images_dir << " in " << synthesis.count() << "s" << std::endl;
+
+    std::string run_config = options.dir + "/config.ini";
+    if (!write_run_config(options, run_config)) return -1;
+    std::string exe = absolute_path(options.exe);
+    std::string report_lines = options.dir + "/report.jsonl";
+    unlink(report_lines.c_str());
+
+    std::ostringstream report;
+    report << "{\"width\": " << options.width << ", \"height\": " << options.height << ", \"format\": \""
+           << options.format << "\", \"images\": " << options.images << ", \"arrival_fps\": " << options.rate
+           << ", \"dir\": \"" << options.dir << "\", \"exe\": \"" << exe << "\", \"patterns\": [";
+    std::streamoff offset = 0;
+    int failed = 0;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        std::cout << "Pattern " << patterns[i] << "..." << std::flush;
+        int status = run_pattern(options, exe, patterns[i]);
+        std::vector<std::string> lines = read_report_lines(report_lines, offset);
+        report << (i ? ", " : "");
+        if (status != 0 || lines.empty()) {
+            // the log of the run tells why
+            std::cout << " failed, exit status " << status << ", see " << options.dir << "/pattern_"
+                    << patterns[i] << ".log" << std::endl;
+            report << "{\"pattern\": " << patterns[i] << ", \"error\": \"exit status " << status << "\"}";
+            failed++;
+            continue;
+        }
+        std::cout << " " << lines.back() << std::endl;
+        report << lines.back();
+    }
+    report << "]}";
+
+    std::ofstream out(options.report);
+    out << report.str() << std::endl;
+    std::cout << "Report written to " << options.report << std::endl;
+    return failed == 0 ? 0 : -1;
+}
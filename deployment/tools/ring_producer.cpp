@@ -0,0 +1,141 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "rtdetr.h"
+#include "rtdetr_utils.h"
+#include "rtdetr_shm_ring.h"
+
+// stands in for a capture process: writes decoded frames to the frame ring of pattern 8
+// and reads the detections back from the results ring.
+
+struct Options {
+    std::string images;
+    std::string frame_ring = "/rtdetr_frames";
+    std::string result_ring = "/rtdetr_results";
+    int loops = 1;
+    int fps = 0;            // 0 writes as fast as the detector takes frames
+    bool drop = false;      // drop frames if the ring is full, as a live camera would
+};
+
+static void usage() {
+    std::cout << "Usage: rtdetr_ring_producer --images dir [--frames /rtdetr_frames] [--results /rtdetr_results]\n"
+              << "                            [--loops 1] [--fps 0] [--drop]" << std::endl;
+}
+
+// the detector creates the rings, wait for it to come up
+static seeta::ShmRing* open_ring(const std::string& name) {
+    for (int i = 0; i < 300; ++i) {
+        seeta::ShmRing* ring = seeta::ShmRing::open(name);
+        if (ring) return ring;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::cerr << "open shared memory " << name << " failed, is pattern 8 running?" << std::endl;
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--images") {
+            options.images = argv[++i];
+        } else if (i + 1 < argc && arg == "--frames") {
+            options.frame_ring = argv[++i];
+        } else if (i + 1 < argc && arg == "--results") {
+            options.result_ring = argv[++i];
+        } else if (i + 1 < argc && arg == "--loops") {
+            options.loops = std::max(1, atoi(argv[++i]));
+        } else if (i + 1 < argc && arg == "--fps") {
+            options.fps = atoi(argv[++i]);
+        } else if (arg == "--drop") {
+            options.drop = true;
+        } else {
+            usage();
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (options.images.empty()) {
+        usage();
+        return -1;
+    }
+
+    // decoded up front, the frames stand for camera buffers
+    std::vector<std::string> names = seeta::FindFilesRecursively(options.images, -1);
+    std::sort(names.begin(), names.end());
+    std::vector<cv::Mat> images;
+    for (const std::string& name : names) {
+        cv::Mat image = cv::imread(options.images + seeta::FileSeparator() + name);
+        if (!image.empty()) images.push_back(image);
+    }
+    if (images.empty()) {
+        std::cerr << "no images in " << options.images << std::endl;
+        return -1;
+    }
+
+    std::unique_ptr<seeta::ShmRing> frames(open_ring(options.frame_ring));
+    std::unique_ptr<seeta::ShmRing> results(open_ring(options.result_ring));
+    if (!frames || !results) {
+        return -1;
+    }
+
+    // results come back in frame order
+    int received = 0;
+    long detections = 0;
+    std::vector<int64_t> latencies;
+    std::thread reader([&] {
+        seeta::ring_slot* result;
+        while ((result = results->begin_read(-1)) != nullptr) {
+            latencies.push_back(seeta::monotonic_us() - result->timestamp_us);
+            detections += result->count;
+            received++;
+            results->end_read();
+        }
+    });
+
+    int written = 0, dropped = 0, skipped = 0;
+    int total = images.size() * options.loops;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < total; ++i) {
+        if (options.fps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(int64_t(i) * 1000000 / options.fps));
+        }
+        const cv::Mat& image = images[i % images.size()];
+        size_t bytes = image.total() * image.elemSize();
+        if (bytes > frames->slot_bytes()) {
+            skipped++;
+            continue;
+        }
+        seeta::ring_slot* frame = frames->begin_write(options.drop ? 0 : -1);
+        if (frame == nullptr) {
+            dropped++;
+            continue;
+        }
+        frame->frame_id = i;
+        frame->width = image.cols;
+        frame->height = image.rows;
+        frame->channels = image.channels();
+        frame->count = 0;
+        memcpy(frame->data, image.data, bytes);
+        // stamped when the frame is complete, the latency covers the detector side only
+        frame->timestamp_us = seeta::monotonic_us();
+        frames->end_write();
+        written++;
+    }
+    frames->close_writer();
+    reader.join();
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Wrote " << written << " frames (" << dropped << " dropped, " << skipped << " larger than a slot), received "
+            << received << " results with " << detections << " detections in " << duration.count() << "s, "
+            << received / duration.count() << " fps" << std::endl;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "Frame to result latency ms p50: " << latencies[latencies.size() / 2] / 1000.0
+                << ", p99: " << latencies[latencies.size() * 99 / 100] / 1000.0 << std::endl;
+    }
+    return 0;
+}
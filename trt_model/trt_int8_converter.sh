@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# calibrates with the images in ../images once, the cache makes later builds fast:
+# trtexec --onnx=../onnx_model/rtdetr-l_op17.onnx --int8 --fp16 --calib=rtdetr-l_int8.cache --saveEngine=rtdetr-l_int8.engine
+../deployment/build/rtdetr_int8  --onnx ../onnx_model/rtdetr-l_op17.onnx  --images ../images  --cache rtdetr-l_int8.cache  --engine rtdetr-l_int8.engine  --max-batches 64 2>&1 | tee int8.log